@@ -1,10 +1,12 @@
+#define _DEFAULT_SOURCE     // getsubopt()
+
 #include "MLFQ.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "msg.h"
-#include <unistd.h>
 
 /**
  * @brief
@@ -13,54 +15,199 @@
 
    Processos começam em filas de prioridade mais alta e, se usarem muito tempo de CPU, descem para filas de prioridade mais baixa.
 
-   Este código já tem parte da lógica de execução e rebaixamento de processos, mas a função de inicialização (create_mlfq) ainda não está implementada.
+   Periodicamente (boost_ms) todas as tarefas voltam ao nível mais prioritário, para que as
+   tarefas longas não morram à fome. Um bitmap dos níveis não vazios permite encontrar a
+   próxima tarefa com um único find-first-set, sem percorrer as filas.
 
-* @param current_time_ms The current time in milliseconds.
- * @param rq Pointer to the ready queue containing tasks that are ready to run.
- * @param cpu_task Double pointer to the currently running task. This will be updated
- *                 to point to the next task to run.
+   Opções (-o): levels=N,quanta=q0:q1:...,boost=ms
  */
-void mlfq_scheduler(uint32_t current_time_ms,mlfq_t *mq, pcb_t **cpu_task) {   // Define a função principal do escalonador
-    if (*cpu_task) {  // Verifica se há um processo em execução na CPU
-        (*cpu_task)->ellapsed_time_ms += TICKS_MS; // Adiciona o tempo de CPU utilizado
-        (*cpu_task)->slice_time += TICKS_MS;  // Incrementa o tempo gasto na fatia atual.
-
-        int nvl = (*cpu_task)->priority_level;   // Guarda o nível de prioridade atual
-
-        if ((*cpu_task)->ellapsed_time_ms >= (*cpu_task)->time_ms) {  // Se o tempo total de execução atingir ou ultrapassar o tempo requerido
-            msg_t msg = {
-                .pid = (*cpu_task)->pid,    //  identifica o processo
-                .request = PROCESS_REQUEST_DONE,   // indica que é um pedido de término
-                .time_ms = current_time_ms   // marca o tempo atual
-            };
-            if (write((*cpu_task)->sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {  // Envia a mensagem pelo socket associado ao processo
-                perror("write");
-            }
-            free((*cpu_task));   // Libera memória do PCB
-            (*cpu_task) = NULL;   // CPU fica desocupado
+
+static void mark_level(mlfq_t *mq, int nvl) {
+    if (queue_empty(&mq->queues[nvl])) {
+        mq->nonempty &= ~(UINT64_C(1) << nvl);
+    } else {
+        mq->nonempty |= UINT64_C(1) << nvl;
+    }
+}
+
+static void enqueue_level(mlfq_t *mq, pcb_t *pcb) {
+    enqueue_pcb(&mq->queues[pcb->priority_level], pcb);
+    mq->nonempty |= UINT64_C(1) << pcb->priority_level;
+}
+
+// Move todas as tarefas para o nível 0, pela ordem dos níveis
+static void boost(mlfq_t *mq, pcb_t *running) {
+    uint64_t lower = mq->nonempty & ~UINT64_C(1);
+    while (lower) {
+        int nvl = __builtin_ctzll(lower);
+        lower &= lower - 1;
+        for (pcb_t *pcb = queue_head(&mq->queues[nvl]); pcb != NULL; pcb = queue_next(pcb)) {
+            pcb->priority_level = 0;
+        }
+        append_queue(&mq->queues[0], &mq->queues[nvl]);
+    }
+    mq->nonempty = queue_empty(&mq->queues[0]) ? 0 : 1;
+    if (running) running->priority_level = 0;
+}
+
+// Aplica os boosts em atraso até current_time_ms
+// Só é chamado por tick(): a tarefa em execução também tem de voltar ao nível 0.
+// Um boost em atraso não muda a ordem das filas, pois o boost junta os níveis pela
+// ordem em que pick_next os serviria.
+static void check_boost(mlfq_t *mq, pcb_t *running, uint32_t current_time_ms) {
+    mq->now_ms = current_time_ms;
+    if (mq->boost_ms == 0 || current_time_ms < mq->next_boost_ms) return;
+    boost(mq, running);
+    while (mq->next_boost_ms <= current_time_ms) {
+        mq->next_boost_ms += mq->boost_ms;
+    }
+}
+
+static void *mlfq_init(const char *options) {
+    int niveis = 0;     // 0: tantos níveis quantos os quanta dados (ou NIVEIS_MLFQ)
+    uint32_t time_slices[MLFQ_MAX_LEVELS];
+    int nquanta = 0;
+    uint32_t boost_ms = MLFQ_DEFAULT_BOOST_MS;
+
+    char *copy = options ? strdup(options) : NULL;
+    char *opts = copy;
+    char *const tokens[] = {"levels", "quanta", "boost", NULL};
+    while (opts && *opts != '\0') {
+        char *value;
+        int key = getsubopt(&opts, tokens, &value);
+        if (key < 0 || !value) {
+            fprintf(stderr, "MLFQ: invalid option, expected levels=N,quanta=q0:q1:...,boost=ms\n");
+            free(copy);
+            return NULL;
         }
-        else if ((*cpu_task)->slice_time >= mq->time_slices[nvl]) {     // Caso o processo não tenha terminado mas tenha usado todo seu time slice
-            (*cpu_task)->slice_time = 0;   // Reinicia contador da fatia
-            if (nvl < mq->niveis - 1) {
-                (*cpu_task)->priority_level = nvl + 1; // desce de nível/prioridade
-            }
-            enqueue_pcb(mq->queues[(*cpu_task)->priority_level], *cpu_task);   // Recoloca o processo na fila de acordo com seu novo nível
-            *cpu_task = NULL;
+        switch (key) {
+            case 0:
+                niveis = atoi(value);
+                if (niveis == 0) niveis = -1;   // levels=0 é inválido
+                break;
+            case 1:
+                for (char *q = strtok(value, ":"); q != NULL && nquanta < MLFQ_MAX_LEVELS; q = strtok(NULL, ":")) {
+                    time_slices[nquanta++] = (uint32_t) strtoul(q, NULL, 10);
+                }
+                break;
+            default:
+                boost_ms = (uint32_t) strtoul(value, NULL, 10);
+                break;
+        }
+    }
+    free(copy);
+
+    if (niveis == 0) {
+        niveis = (nquanta > 0) ? nquanta : NIVEIS_MLFQ;
+    }
+    if (niveis < 1 || niveis > MLFQ_MAX_LEVELS) {
+        fprintf(stderr, "MLFQ: levels must be between 1 and %d\n", MLFQ_MAX_LEVELS);
+        return NULL;
+    }
+    // Níveis sem quantum explícito dobram o quantum do nível anterior (satura em UINT32_MAX)
+    for (int i = nquanta; i < niveis; i++) {
+        if (i == 0) {
+            time_slices[i] = MLFQ_DEFAULT_QUANTUM_MS;
+        } else {
+            time_slices[i] = (time_slices[i - 1] > UINT32_MAX / 2) ? UINT32_MAX : time_slices[i - 1] * 2;
         }
     }
-    if (*cpu_task == NULL) {         // Se CPU está livre
-        for (int i = 0; i < mq->niveis; i++) {
-            *cpu_task = dequeue_pcb(mq->queues[i]);  // processo da fila mais prioriatria
-            if (*cpu_task) {
-                (*cpu_task)->slice_time = 0;  // reinicia slice
-                break;     // sai do loop
-            }
+    for (int i = 0; i < niveis; i++) {
+        if (time_slices[i] == 0) {
+            fprintf(stderr, "MLFQ: quantum of level %d must be positive\n", i);
+            return NULL;
         }
     }
+    return create_mlfq(niveis, time_slices, boost_ms);
 }
 
+static int mlfq_enqueue(void *state, pcb_t *pcb, uint32_t current_time_ms) {
+    mlfq_t *mq = state;
+    mq->now_ms = current_time_ms;   // o boost fica para tick(), que conhece a tarefa em execução
+    if (pcb->priority_level >= mq->niveis) {
+        pcb->priority_level = mq->niveis - 1;
+    }
+    enqueue_level(mq, pcb);   // novas tarefas chegam com nível 0 (new_pcb)
+    return 1;
+}
+
+static pcb_t *mlfq_pick_next(void *state, uint32_t current_time_ms) {
+    mlfq_t *mq = state;
+    mq->now_ms = current_time_ms;   // idem: pode ser chamado por outro core (roubo de tarefas)
+    if (mq->nonempty == 0) return NULL;
+    int nvl = __builtin_ctzll(mq->nonempty);   // nível mais prioritário com tarefas
+    pcb_t *next = dequeue_pcb(&mq->queues[nvl]);
+    mark_level(mq, nvl);
+    next->slice_time = 0;  // reinicia slice
+    return next;
+}
+
+static sched_tick_en mlfq_tick(void *state, pcb_t *running, uint32_t current_time_ms, uint32_t elapsed_ms) {
+    mlfq_t *mq = state;
+    check_boost(mq, running, current_time_ms);
+    running->ellapsed_time_ms += elapsed_ms; // Adiciona o tempo de CPU utilizado
+    running->slice_time += elapsed_ms;  // Incrementa o tempo gasto na fatia atual.
 
-// TODO: Create this function
-mlfq_t *create_mlfq() {
-    return NULL;
-};
\ No newline at end of file
+    int nvl = running->priority_level;   // Guarda o nível de prioridade atual
+
+    if (running->ellapsed_time_ms >= running->time_ms) {  // Se o tempo total de execução atingir ou ultrapassar o tempo requerido
+        return SCHED_TICK_DONE;
+    }
+    if (running->slice_time >= mq->time_slices[nvl]) {     // Caso o processo não tenha terminado mas tenha usado todo seu time slice
+        running->slice_time = 0;   // Reinicia contador da fatia
+        if (nvl < mq->niveis - 1) {
+            running->priority_level = nvl + 1; // desce de nível/prioridade
+        }
+        enqueue_level(mq, running);   // Recoloca o processo na fila de acordo com seu novo nível
+        return SCHED_TICK_PREEMPTED;
+    }
+    return SCHED_TICK_CONTINUE;
+}
+
+static uint32_t mlfq_run_time_left(void *state, const pcb_t *running) {
+    mlfq_t *mq = state;
+    uint32_t left = sched_time_left(running);
+    uint32_t slice_ms = mq->time_slices[running->priority_level];
+    uint32_t slice_left = (running->slice_time < slice_ms) ? slice_ms - running->slice_time : 0;
+    if (slice_left < left) left = slice_left;
+    // O boost muda o quantum da tarefa em execução, não pode ser saltado
+    if (mq->boost_ms != 0 && running->priority_level != 0) {
+        uint32_t boost_left = (mq->next_boost_ms > mq->now_ms) ? mq->next_boost_ms - mq->now_ms : 0;
+        if (boost_left < left) left = boost_left;
+    }
+    return left;
+}
+
+static void mlfq_destroy(void *state) {
+    mlfq_t *mq = state;
+    free(mq->queues);
+    free(mq->time_slices);
+    free(mq);
+}
+
+const sched_policy_t mlfq_policy = {
+    .name = "MLFQ",
+    .init = mlfq_init,
+    .enqueue = mlfq_enqueue,
+    .pick_next = mlfq_pick_next,
+    .tick = mlfq_tick,
+    .run_time_left = mlfq_run_time_left,
+    .destroy = mlfq_destroy,
+};
+
+mlfq_t *create_mlfq(int niveis, const uint32_t *time_slices, uint32_t boost_ms) {
+    if (niveis < 1 || niveis > MLFQ_MAX_LEVELS) return NULL;
+    mlfq_t *mq = calloc(1, sizeof(mlfq_t));
+    if (!mq) return NULL;
+    mq->queues = calloc((size_t) niveis, sizeof(queue_t));   // filas vazias (PCB_HANDLE_NONE é 0)
+    mq->time_slices = malloc((size_t) niveis * sizeof(uint32_t));
+    if (!mq->queues || !mq->time_slices) {
+        mlfq_destroy(mq);
+        return NULL;
+    }
+    memcpy(mq->time_slices, time_slices, (size_t) niveis * sizeof(uint32_t));
+    mq->niveis = niveis;
+    mq->boost_ms = boost_ms;
+    mq->next_boost_ms = boost_ms;
+    return mq;
+}
@@ -1,17 +1,35 @@
 #ifndef MLFQ_H
 #define MLFQ_H
-#define NIVEIS_MLFQ 3
-#include "queue.h"
+
+#include <stdint.h>
+
+#include "sched_policy.h"
+
+#define NIVEIS_MLFQ 3                   // Número de níveis por omissão
+#define MLFQ_MAX_LEVELS 64              // Um bit por nível no bitmap de filas não vazias
+#define MLFQ_DEFAULT_QUANTUM_MS 500     // Fatia do nível 0, duplica a cada nível
+#define MLFQ_DEFAULT_BOOST_MS 5000      // Período do priority boost (0 desliga)
 
 typedef struct {
-    queue_t *queues[NIVEIS_MLFQ];
-    uint32_t time_slices[NIVEIS_MLFQ];
-    int niveis;
+    queue_t *queues;            // Uma fila de prontos por nível, 0 é o mais prioritário
+    uint32_t *time_slices;      // Fatia de tempo (quantum) de cada nível em ms
+    int niveis;                 // Número de níveis
+    uint64_t nonempty;          // Bit i ligado se queues[i] tem tarefas
+    uint32_t boost_ms;          // Período do priority boost em ms (0 desliga)
+    uint32_t next_boost_ms;     // Instante do próximo boost
+    uint32_t now_ms;            // Último instante visto pela política
 } mlfq_t;
 
-void mlfq_scheduler(uint32_t current_time_ms,mlfq_t *mq, pcb_t **cpu_task);
-
+extern const sched_policy_t mlfq_policy;
 
-mlfq_t *create_mlfq();
+/**
+ * @brief Create an MLFQ
+ *
+ * @param niveis Number of levels (1 to MLFQ_MAX_LEVELS)
+ * @param time_slices Time slice of each level in milliseconds
+ * @param boost_ms Period of the priority boost in milliseconds, or 0 to disable it
+ * @return The new MLFQ, or NULL on failure
+ */
+mlfq_t *create_mlfq(int niveis, const uint32_t *time_slices, uint32_t boost_ms);
 
 #endif //MLFQ_H
@@ -1,8 +1,10 @@
 #ifndef RR_H
 #define RR_H
 
-#include "queue.h"
+#include "sched_policy.h"
 
-void rr_scheduler(uint32_t current_time_ms, queue_t *rq, pcb_t **cpu_task);
+#define TIME_SLICE_MS 500
+
+extern const sched_policy_t rr_policy;
 
 #endif //RR_H
@@ -1,42 +1,65 @@
 #include "SJF.h"
 
-#include <stdio.h>
 #include <stdlib.h>
 
 #include "msg.h"
-#include <unistd.h>
+#include "heap_queue.h"
 
 /**
  * @brief Shortest Job First (SJF) scheduling algorithm.
  *
- * This function implements the SJF scheduling algorithm. If the CPU is not idle it
- * checks if the application is ready and frees the CPU.
- * If the CPU is idle, it selects the next task to run based on the order they were added
- * to the ready queue. The task that has been in the queue the longest is selected to run next.
- *
- * @param current_time_ms The current time in milliseconds.
- * @param rq Pointer to the ready queue containing tasks that are ready to run.
- * @param cpu_task Double pointer to the currently running task. This will be updated
- *                 to point to the next task to run.
+ * This policy implements the (non-preemptive) SJF scheduling algorithm. A task keeps
+ * the CPU until it has used all the time it requested.
+ * Ready tasks are kept in a binary heap ordered by requested time. When the CPU is idle,
+ * the task with the shortest requested time is popped from the heap in O(log n); among
+ * equal times, the one that arrived first runs first.
  */
-void sjf_scheduler(uint32_t current_time_ms, queue_t *rq, pcb_t **cpu_task) {  // Função de escalonamento SJF. Recebe tempo atual, fila de prontos e ponteiro duplo para a tarefa no CPU
-    if (*cpu_task) {        // Se existe uma tarefa em execução
-        (*cpu_task)->ellapsed_time_ms += TICKS_MS;       // Incrementa o tempo já executado do processo
-        if ((*cpu_task)->ellapsed_time_ms >= (*cpu_task)->time_ms) {  // Se o tempo executado atingiu o necessário
-            msg_t msg = {  // Monta uma mensagem para sinalizar término
-                    .pid = (*cpu_task)->pid,   // PID do processo concluído
-                    .request = PROCESS_REQUEST_DONE,  // Indica fim do processo
-                    .time_ms = current_time_ms  // Tempo de conclusão
-            };
-            if (write((*cpu_task)->sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {  // Envia a mensagem por socket
-                perror("write");
-            }
-
-            free((*cpu_task));   // Libera a memória do processo finalizado
-            (*cpu_task) = NULL;  // Marca que não há mais tarefa rodando
-        }
-    }
-    if (*cpu_task == NULL) {        // Se o processador está livre (nenhuma tarefa rodando)
-        *cpu_task = dequeue_short(rq);    // Retira o processo com menor tempo da fila de prontos e coloca na CPU
-    }
-}
\ No newline at end of file
+
+typedef struct {
+    heap_queue_t ready_heap;    // Tarefas prontas ordenadas por tempo pedido (e ordem de chegada)
+} sjf_state_t;
+
+static void *sjf_init(const char *options) {
+    (void) options;
+    return calloc(1, sizeof(sjf_state_t));
+}
+
+static int sjf_enqueue(void *state, pcb_t *pcb, uint32_t current_time_ms) {
+    (void) current_time_ms;
+    sjf_state_t *sjf = state;
+    return heap_push(&sjf->ready_heap, pcb, pcb->time_ms);  // 0 se o heap não pôde crescer
+}
+
+static pcb_t *sjf_pick_next(void *state, uint32_t current_time_ms) {
+    (void) current_time_ms;
+    sjf_state_t *sjf = state;
+    return heap_pop_min(&sjf->ready_heap);    // Retira o processo com menor tempo do heap
+}
+
+static sched_tick_en sjf_tick(void *state, pcb_t *running, uint32_t current_time_ms, uint32_t elapsed_ms) {
+    (void) state;
+    (void) current_time_ms;
+    running->ellapsed_time_ms += elapsed_ms;    // Incrementa o tempo já executado do processo
+    return (running->ellapsed_time_ms >= running->time_ms) ? SCHED_TICK_DONE : SCHED_TICK_CONTINUE;
+}
+
+static uint32_t sjf_run_time_left(void *state, const pcb_t *running) {
+    (void) state;
+    return sched_time_left(running);
+}
+
+static void sjf_destroy(void *state) {
+    sjf_state_t *sjf = state;
+    heap_queue_free(&sjf->ready_heap);
+    free(sjf);
+}
+
+const sched_policy_t sjf_policy = {
+    .name = "SJF",
+    .init = sjf_init,
+    .enqueue = sjf_enqueue,
+    .pick_next = sjf_pick_next,
+    .tick = sjf_tick,
+    .run_time_left = sjf_run_time_left,
+    .destroy = sjf_destroy,
+};
@@ -1,9 +1,8 @@
 #ifndef SJF_H
 #define SJF_H
 
-#include "queue.h"
+#include "sched_policy.h"
 
-//Mudar para a funcao SJF
-void sjf_scheduler(uint32_t current_time_ms, queue_t *rq, pcb_t **cpu_task);
+extern const sched_policy_t sjf_policy;
 
 #endif //SJF_H
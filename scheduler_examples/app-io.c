@@ -1,8 +1,8 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <sys/socket.h>
-#include <sys/un.h>
+#include <string.h>
 #include <fcntl.h>
+#include <getopt.h>
 #include <limits.h>
 #include <unistd.h>
 
@@ -10,7 +10,10 @@
 #include "debug.h"
 
 #include "msg.h"
+#include "app_proto.h"
 #include "burst_queue.h"
+#include "sched_client.h"
+#include "util.h"
 
 /**
  * Extracts the basename of a file without its extension.
@@ -38,121 +41,210 @@ typedef enum {
     process_terminated
 } process_status_en;
 
-process_status_en handle_process_requests(int sockfd, const pid_t pid, const char *app_name, burst_t *burst, process_request_t request, uint32_t *sim_start_time_ms, uint32_t *sim_clock_ms) {
-    msg_t msg = {
-        .pid = pid,
-        .request = request,
-        .time_ms = (request == PROCESS_REQUEST_RUN)?burst->burst_time_ms:burst->block_time_ms
-    };
+process_status_en handle_process_requests(sched_client_t *client, const pid_t pid, const char *app_name, app_state_t *app, msg_t *msg, uint16_t flags) {
     // Send request
-    if (write(sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
-        perror("write");
-        close(sockfd);
+    if (sched_client_send_flags(client, msg, flags) < 0) {
         return process_error;
     }
     DBG("Application %s (PID %d) sent %s request for %u ms",
-           app_name, pid, PROCESS_REQUEST_STRINGS[request], msg.time_ms);
-    // Wait for ACK and the internal simulation time
-    if (read(sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
-        perror("read");
-        close(sockfd);
+           app_name, pid, PROCESS_REQUEST_STRINGS[msg->request], msg->time_ms);
+    // Wait for the ACK (unless we asked for none) and the DONE, with the internal simulation time
+    int done;
+    do {
+        if (sched_client_recv(client, msg) < 0) {
+            return process_error;
+        }
+        if ((done = app_handle_reply(app, msg)) < 0) {
+            return process_error;
+        }
+        DBG("Received %s from scheduler for application %s (PID %d) at time %u ms\n",
+               PROCESS_REQUEST_STRINGS[msg->request], app_name, pid, app->sim_clock_ms);
+    } while (!done);
+    return process_success;
+}
+
+/**
+ * Uploads all the bursts as one script and waits for the final report of the
+ * scheduler, instead of one RUN/BLOCK round trip per burst.
+ *
+ * @return The final report, or process_error
+ */
+process_status_en run_script(sched_client_t *client, const pid_t pid, const char *app_name, const burst_queue_t *bursts, uint32_t flags, script_report_t *report) {
+    if (sched_client_send_script(client, bursts, flags) < 0) {
         return process_error;
     }
-    if (msg.request != PROCESS_REQUEST_ACK) {
-        printf("Received invalid request. Expected ACK, received %s\n", PROCESS_REQUEST_STRINGS[msg.request]);
+    msg_t msg;
+    if (sched_client_recv(client, &msg) < 0) {
         return process_error;
     }
-    *sim_clock_ms = msg.time_ms;
-    if (*sim_start_time_ms == 0) *sim_start_time_ms = *sim_clock_ms; // First burst, set the start time
-    DBG("Received %s from scheduler for application %s (PID %d) at time %u ms\n",
-           PROCESS_REQUEST_STRINGS[msg.request], app_name, pid, *sim_clock_ms);
-
-    // Wait for DONE and the internal simulation time
-    if (read(sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
-        perror("read");
-        close(sockfd);
+    if (msg.request != PROCESS_REQUEST_ACK) {
+        printf("Received invalid request. Expected ACK, received %s\n", PROCESS_REQUEST_STRINGS[msg.request]);
         return process_error;
     }
+    DBG("Application %s (PID %d) uploaded its script at time %u ms\n", app_name, pid, msg.time_ms);
 
-    if (msg.request != PROCESS_REQUEST_DONE) {
-        printf("Received invalid request. Expected DONE, received %s\n", PROCESS_REQUEST_STRINGS[msg.request]);
+    // One DONE per burst (progress), then the report
+    for (;;) {
+        if (sched_client_recv(client, &msg) < 0) {
+            return process_error;
+        }
+        if (msg.request == PROCESS_REQUEST_REPORT) break;
+        if (msg.request != PROCESS_REQUEST_DONE) {
+            printf("Received invalid request. Expected DONE, received %s\n", PROCESS_REQUEST_STRINGS[msg.request]);
+            return process_error;
+        }
+        DBG("Received %s from scheduler for application %s (PID %d) at time %u ms\n",
+               PROCESS_REQUEST_STRINGS[msg.request], app_name, pid, msg.time_ms);
+    }
+    if (sched_client_recv_report(client, &msg, report) < 0) {
         return process_error;
     }
-    *sim_clock_ms = msg.time_ms;
-    DBG("Received %s from scheduler for application %s (PID %d) at time %u ms\n",
-           PROCESS_REQUEST_STRINGS[msg.request], app_name, pid, *sim_clock_ms);
-
     return process_success;
 }
 
+// --stream --parse-only: read the whole stream and print how fast it went
+static int drain_stream(burst_queue_t *bursts, const char *burstfile_name) {
+    double t0 = now_s();
+    while (dequeue_burst(bursts) != NULL) {}
+    double seconds = now_s() - t0;
+    printf("Streamed %zu bursts from %s in %.3f ms\n", bursts->count, burstfile_name, seconds * 1000.0);
+    free_burst_queue(bursts);
+    return EXIT_SUCCESS;
+}
+
 /*
- * Run like: ./app-pre <burst-file.csv>
+ * Run like: ./app-io [--shm | --v2] [--no-ack] [--script [--final-only] | --stream] [--parse-only] <burst-file.csv>
  */
 int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        printf("Usage: %s <burst-file.csv>\n", argv[0]);
+    int use_shm = 0;    // 1 to talk to the scheduler through shared memory
+    int use_script = 0; // 1 to upload all bursts at once
+    uint32_t script_flags = 0;
+    int use_v2 = 0;     // 1 to negotiate protocol v2
+    int no_ack = 0;     // 1 to skip the ACK of every request but the first
+    int parse_only = 0; // 1 to only parse the burst file and print the throughput
+    int use_stream = 0; // 1 to read the burst file as the bursts are sent
+    static const struct option long_options[] = {
+        {"shm", no_argument, NULL, 's'},
+        {"v2", no_argument, NULL, '2'},
+        {"no-ack", no_argument, NULL, 'n'},
+        {"script", no_argument, NULL, 'S'},
+        {"final-only", no_argument, NULL, 'f'},
+        {"parse-only", no_argument, NULL, 'p'},
+        {"stream", no_argument, NULL, 'r'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "s2nSfpr", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 's':
+                use_shm = 1;
+                break;
+            case 'S':
+                use_script = 1;
+                break;
+            case 'f':
+                script_flags |= SCRIPT_FLAG_FINAL_REPORT;
+                break;
+            case '2':
+                use_v2 = 1;
+                break;
+            case 'n':
+                no_ack = 1;
+                break;
+            case 'p':
+                parse_only = 1;
+                break;
+            case 'r':
+                use_stream = 1;
+                break;
+            default:
+                printf("Usage: %s [--shm | --v2] [--no-ack] [--script [--final-only] | --stream] [--parse-only] <burst-file.csv>\n", argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (argc - optind != 1 || (use_shm && (use_script || use_v2)) || (no_ack && use_script) || (script_flags && !use_script) || (use_stream && use_script)) {
+        printf("Usage: %s [--shm | --v2] [--no-ack] [--script [--final-only] | --stream] [--parse-only] <burst-file.csv>\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
     // Parse arguments
-    const char *burstfile_name = argv[1];
+    const char *burstfile_name = argv[optind];
     char *app_name = get_basename_no_ext(burstfile_name);
 
-    burst_queue_t bursts = {.head = NULL, .tail = NULL};
+    burst_queue_t bursts = {0};
+    burst_parse_stats_t parse_stats;
+    int loaded = 0;                         // Bursts read (or to be generated)
 
-    if (read_queue_from_file(&bursts, burstfile_name) <= 0) {
+    if (use_stream) {
+        if (open_burst_stream(&bursts, burstfile_name) < 0) {
+            fprintf(stderr, "Failed to open burst file %s\n", burstfile_name);
+            return EXIT_FAILURE;
+        }
+        if (parse_only) return drain_stream(&bursts, burstfile_name);
+    } else if ((loaded = read_queue_from_file_stats(&bursts, burstfile_name, &parse_stats)) <= 0) {
         fprintf(stderr, "Failed to read burst file %s\n", burstfile_name);
         return EXIT_FAILURE;
     }
-
-    // Setup socket for communication
-    int sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (sockfd < 0) {
-        perror("socket");
+    if (!use_stream) {
+        double mb_per_s = (parse_stats.seconds > 0) ? (double) parse_stats.bytes / 1e6 / parse_stats.seconds : 0;
+        if (parse_only) {
+            printf("Loaded %d bursts (%zu bytes) from %s in %.3f ms, %.1f MB/s\n",
+                   loaded, parse_stats.bytes, burstfile_name, parse_stats.seconds * 1000.0, mb_per_s);
+            free_burst_queue(&bursts);
+            free(app_name);
+            return EXIT_SUCCESS;
+        }
+        DBG("Parsed %d bursts from %s at %.1f MB/s", loaded, burstfile_name, mb_per_s);
+    }
+    // The script is uploaded at once: generate all of it first
+    if (use_script && burst_queue_expand(&bursts) < 0) {
         return EXIT_FAILURE;
     }
 
-    struct sockaddr_un addr = {0};
-    addr.sun_family = AF_UNIX;
-    strncpy(addr.sun_path, SOCKET_PATH, sizeof(addr.sun_path) - 1);
-
-    if (connect(sockfd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        perror("connect");
-        close(sockfd);
+    // Setup the connection to the scheduler
+    sched_client_t client;
+    if (sched_client_connect(&client, use_shm) < 0) {
+        return EXIT_FAILURE;
+    }
+    if (use_v2 && sched_client_hello(&client) < 0) {
+        sched_client_close(&client);
         return EXIT_FAILURE;
     }
 
     pid_t pid = getpid();
-    uint32_t sim_clock_ms = 0;              // Clock of the scheduler
-
-    uint32_t start_time_ms = 0;             // Start time of the app
-    uint32_t cpu_duration_ms = 0;           // duration of the app (bursts and blocks)
-    uint32_t block_duration_ms = 0;         // duration of the app in blocked state
-
-    burst_t *active_burst;
-
-    while ((active_burst = dequeue_burst(&bursts)) != NULL) {
-        printf("[DEBUG] Burst CPU: %u ms, Block: %u ms\n", active_burst->burst_time_ms, active_burst->block_time_ms);
-        if (handle_process_requests(sockfd, pid, app_name, active_burst, PROCESS_REQUEST_RUN, &start_time_ms, &sim_clock_ms) == process_error)
-            break;
-        cpu_duration_ms += active_burst->burst_time_ms;
+    app_state_t app = {0};                  // Progress and times of the app
+    msg_t msg;
+    uint16_t flags = 0;                     // MSG_FLAG_* of the next request
+
+    if (use_script) {
+        script_report_t report;
+        if (run_script(&client, pid, app_name, &bursts, script_flags, &report) != process_success) {
+            fprintf(stderr, "Application %s (PID %d) did not get the report of its script\n", app_name, pid);
+            sched_client_close(&client);
+            free_burst_queue(&bursts);
+            free(app_name);
+            return EXIT_FAILURE;
+        }
+        app.start_time_ms = report.start_time_ms;
+        app.sim_clock_ms = report.end_time_ms;
+        app.cpu_duration_ms = report.cpu_time_ms;
+        app.block_duration_ms = report.block_time_ms;
+    }
 
-        if (active_burst->block_time_ms > 0) {
-            if (handle_process_requests(sockfd, pid, app_name, active_burst, PROCESS_REQUEST_BLOCK, &start_time_ms, &sim_clock_ms) == process_error)
-                break;
-            block_duration_ms += active_burst->block_time_ms;
+    while (!use_script && app_next_request(&app, &bursts, pid, &msg)) {
+        if (msg.request == PROCESS_REQUEST_RUN) {
+            printf("[DEBUG] Burst CPU: %u ms, Block: %u ms\n", app.active->burst_time_ms, app.active->block_time_ms);
         }
+        if (handle_process_requests(&client, pid, app_name, &app, &msg, flags) == process_error)
+            break;
+        if (no_ack) flags = MSG_FLAG_NO_ACK;   // the first ACK gave us the start time
     }
 
     // Received EXIT, print stats
-    double real = (sim_clock_ms - start_time_ms)/1000.0;
-    double user = (double)cpu_duration_ms/1000.0;
-    double sys = (double)block_duration_ms/1000.0;
-
-    printf("Application %s (PID %d) finished at time %d ms, Elapsed: %.03f seconds, CPU: %.03f seconds, BLOCKED: %.03f seconds\n",
-           app_name, pid, sim_clock_ms, real, user, sys);
+    app_print_report(&app, app_name, pid);
 
-    close(sockfd);
+    sched_client_close(&client);
+    free_burst_queue(&bursts);
     free(app_name);
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -1,8 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <sys/socket.h>
-#include <sys/un.h>
 #include <fcntl.h>
+#include <getopt.h>
 #include <limits.h>
 #include <unistd.h>
 #include <sys/errno.h>
@@ -10,27 +9,41 @@
 #include "debug.h"
 
 #include "msg.h"
+#include "sched_client.h"
 
 /*
- * Run like: ./app <name> <time_s>
+ * Run like: ./app [--shm] <name> <time_s>
  */
 int main(int argc, char *argv[]) {
-    if (argc != 3) {
-        printf("Usage: %s <name> <time_s>\n", argv[0]);
+    int use_shm = 0;    // 1 to talk to the scheduler through shared memory
+    static const struct option long_options[] = {
+        {"shm", no_argument, NULL, 's'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "s", long_options, NULL)) != -1) {
+        if (opt != 's') {
+            printf("Usage: %s [--shm] <name> <time_s>\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+        use_shm = 1;
+    }
+    if (argc - optind != 2) {
+        printf("Usage: %s [--shm] <name> <time_s>\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
     // Parse arguments
-    const char *app_name = argv[1];
+    const char *app_name = argv[optind];
     char *endptr;
     errno = 0;
-    long val = strtol(argv[2], &endptr, 10);
+    long val = strtol(argv[optind + 1], &endptr, 10);
     if (errno != 0) {
         perror("strtol");  // conversion error (overflow, etc.)
         return 1;
     }
     if (*endptr != '\0') {
-        fprintf(stderr, "Invalid number: %s\n", argv[2]);
+        fprintf(stderr, "Invalid number: %s\n", argv[optind + 1]);
         return 1;
     }
     if (val < 0 || val > INT_MAX) {  // optional range check
@@ -39,20 +52,9 @@ int main(int argc, char *argv[]) {
     }
     int32_t time_s = (int32_t) val;
 
-    // Setup socket for communication
-    int sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (sockfd < 0) {
-        perror("socket");
-        return EXIT_FAILURE;
-    }
-
-    struct sockaddr_un addr = {0};
-    addr.sun_family = AF_UNIX;
-    strncpy(addr.sun_path, SOCKET_PATH, sizeof(addr.sun_path) - 1);
-
-    if (connect(sockfd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        perror("connect");
-        close(sockfd);
+    // Setup the connection to the scheduler
+    sched_client_t client;
+    if (sched_client_connect(&client, use_shm) < 0) {
         return EXIT_FAILURE;
     }
 
@@ -66,17 +68,15 @@ int main(int argc, char *argv[]) {
         .request = PROCESS_REQUEST_RUN,
         .time_ms = time_s * 1000
     };
-    if (write(sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
-        perror("write");
-        close(sockfd);
+    if (sched_client_send(&client, &msg) < 0) {
+        sched_client_close(&client);
         return EXIT_FAILURE;
     }
     DBG("Application %s (PID %d) sent RUN request for %d ms",
            app_name, pid, msg.time_ms);
     // Wait for ACK and the internal simulation time
-    if (read(sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
-        perror("read");
-        close(sockfd);
+    if (sched_client_recv(&client, &msg) < 0) {
+        sched_client_close(&client);
         return EXIT_FAILURE;
     }
     if (msg.request != PROCESS_REQUEST_ACK) {
@@ -89,9 +89,8 @@ int main(int argc, char *argv[]) {
 //    printf("Application %s (PID %d) started running at time %d ms\n", app_name, pid, start_time_ms);
 
     // Wait for the EXIT message
-    if (read(sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
-        perror("read");
-        close(sockfd);
+    if (sched_client_recv(&client, &msg) < 0) {
+        sched_client_close(&client);
         return EXIT_FAILURE;
     }
     if (msg.request != PROCESS_REQUEST_DONE) {
@@ -106,6 +105,6 @@ int main(int argc, char *argv[]) {
     printf("Application %s (PID %d) finished at time %d ms, Elapsed: %.03f seconds, CPU: %.03f seconds\n",
            app_name, pid, msg.time_ms, real, user);
 
-    close(sockfd);
+    sched_client_close(&client);
     return EXIT_SUCCESS;
 }
\ No newline at end of file
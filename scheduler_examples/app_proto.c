@@ -0,0 +1,46 @@
+#include "app_proto.h"
+
+#include <stdio.h>
+
+int app_next_request(app_state_t *app, burst_queue_t *bursts, pid_t pid, msg_t *msg) {
+    if (app->active && app->request == PROCESS_REQUEST_RUN && app->active->block_time_ms > 0) {
+        app->request = PROCESS_REQUEST_BLOCK;   // o burst bloqueia depois de correr
+    } else if ((app->active = dequeue_burst(bursts)) != NULL) {
+        app->request = PROCESS_REQUEST_RUN;
+    } else {
+        return 0;
+    }
+    msg->pid = pid;
+    msg->request = app->request;
+    msg->time_ms = (app->request == PROCESS_REQUEST_RUN) ? app->active->burst_time_ms : app->active->block_time_ms;
+    return 1;
+}
+
+int app_handle_reply(app_state_t *app, const msg_t *msg) {
+    switch (msg->request) {
+        case PROCESS_REQUEST_ACK:
+            app->sim_clock_ms = msg->time_ms;
+            if (app->start_time_ms == 0) app->start_time_ms = msg->time_ms;   // First burst, set the start time
+            return 0;
+        case PROCESS_REQUEST_DONE:
+            app->sim_clock_ms = msg->time_ms;
+            if (app->request == PROCESS_REQUEST_RUN) {
+                app->cpu_duration_ms += app->active->burst_time_ms;
+            } else {
+                app->block_duration_ms += app->active->block_time_ms;
+            }
+            return 1;
+        default:
+            printf("Received invalid request. Expected ACK or DONE, received %s\n", PROCESS_REQUEST_STRINGS[msg->request]);
+            return -1;
+    }
+}
+
+void app_print_report(const app_state_t *app, const char *app_name, pid_t pid) {
+    double real = (app->sim_clock_ms - app->start_time_ms)/1000.0;
+    double user = (double)app->cpu_duration_ms/1000.0;
+    double sys = (double)app->block_duration_ms/1000.0;
+
+    printf("Application %s (PID %d) finished at time %d ms, Elapsed: %.03f seconds, CPU: %.03f seconds, BLOCKED: %.03f seconds\n",
+           app_name, pid, app->sim_clock_ms, real, user, sys);
+}
@@ -0,0 +1,53 @@
+#ifndef APP_PROTO_H
+#define APP_PROTO_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "burst_queue.h"
+#include "msg.h"
+
+// Define the progress of an application through its bursts
+// Each burst is a RUN request followed, if it has a block time, by a BLOCK
+// request. Each request gets an ACK (unless it asked for none) and then a DONE.
+// The state only builds the requests and follows the replies, so it works the
+// same with a blocking connection (app-io) or many non-blocking ones (loadgen).
+typedef struct app_state_st {
+    burst_t *active;                // Burst being run (NULL before the first)
+    process_request_t request;      // Request waiting for its DONE
+    uint32_t start_time_ms;         // Time of the first ACK
+    uint32_t sim_clock_ms;          // Time of the last reply
+    uint32_t cpu_duration_ms;       // CPU time of the bursts done
+    uint32_t block_duration_ms;     // Block time of the bursts done
+} app_state_t;
+
+/**
+ * @brief Build the next request of an application
+ *
+ * @param app The application
+ * @param bursts Its bursts
+ * @param pid The pid sent in the request
+ * @param msg Receives the request
+ * @return 1 if there is a request to send, 0 if the application is done
+ */
+int app_next_request(app_state_t *app, burst_queue_t *bursts, pid_t pid, msg_t *msg);
+
+/**
+ * @brief Follow a reply of the scheduler to the current request
+ *
+ * @param app The application
+ * @param msg The reply
+ * @return 1 if the request is done, 0 if its DONE is still to come, -1 if the reply was not expected
+ */
+int app_handle_reply(app_state_t *app, const msg_t *msg);
+
+/**
+ * @brief Print the final line of an application: elapsed, CPU and blocked times
+ *
+ * @param app The application
+ * @param app_name Its name
+ * @param pid Its pid
+ */
+void app_print_report(const app_state_t *app, const char *app_name, pid_t pid);
+
+#endif //APP_PROTO_H
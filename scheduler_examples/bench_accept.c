@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "msg.h"
+#include "util.h"
+
+/*
+ * Measures how fast a running scheduler accepts connections. Each round opens
+ * all the connections back to back, then sends a HELLO on each one and waits
+ * for every ACK (the HELLO is answered by the I/O thread, so a connection
+ * counts once the scheduler has accepted it and read from it). All connections
+ * are closed at the end of the round, so later rounds also check that the
+ * scheduler gives their fds and slots back.
+ *
+ * Run like: ./scheduler --max-procs 20000 FIFO & ./bench_accept [connections] [rounds]
+ */
+
+static int connect_scheduler(void) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, SOCKET_PATH, sizeof(addr.sun_path) - 1);
+    if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        perror("connect");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int run(int *fds, uint32_t conns) {
+    double t0 = now_s();
+    for (uint32_t i = 0; i < conns; i++) {
+        fds[i] = connect_scheduler();
+        if (fds[i] < 0) {
+            fprintf(stderr, "Connection %u failed\n", i);
+            for (uint32_t j = 0; j < i; j++) close(fds[j]);
+            return -1;
+        }
+    }
+    double t1 = now_s();
+    msg_t msg = {.pid = getpid(), .request = PROCESS_REQUEST_HELLO, .time_ms = PROTOCOL_V1};
+    uint32_t answered = 0;
+    for (uint32_t i = 0; i < conns; i++) {
+        if (write(fds[i], &msg, sizeof(msg_t)) != sizeof(msg_t)) perror("write");
+    }
+    for (uint32_t i = 0; i < conns; i++) {
+        msg_t ack;
+        if (read(fds[i], &ack, sizeof(msg_t)) == sizeof(msg_t) && ack.request == PROCESS_REQUEST_ACK) answered++;
+    }
+    double t2 = now_s();
+    for (uint32_t i = 0; i < conns; i++) close(fds[i]);
+
+    printf("%8u connections  connect: %9.0f/s  accepted and answered: %9.0f/s  (%u/%u answered)\n",
+           conns, conns / (t1 - t0), answered / (t2 - t0), answered, conns);
+    return (answered == conns) ? 0 : -1;
+}
+
+int main(int argc, char *argv[]) {
+    int conns = (argc > 1) ? atoi(argv[1]) : 10000;
+    int rounds = (argc > 2) ? atoi(argv[2]) : 3;
+    if (conns <= 0 || rounds <= 0) {
+        printf("Usage: %s [connections] [rounds]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    raise_fd_limit((uint64_t) conns + 16);   // um fd por ligação
+    int *fds = malloc((size_t) conns * sizeof(int));
+    if (!fds) {
+        perror("malloc");
+        return EXIT_FAILURE;
+    }
+    int ret = EXIT_SUCCESS;
+    for (int r = 0; r < rounds; r++) {
+        if (run(fds, (uint32_t) conns) < 0) {
+            ret = EXIT_FAILURE;
+            break;
+        }
+        usleep(200000);     // let the scheduler see the hang-ups before the next round
+    }
+    free(fds);
+    return ret;
+}
@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "msg.h"
+#include "queue.h"
+#include "pcb_pool.h"
+#include "timer_wheel.h"
+#include "util.h"
+
+/*
+ * Measures the per-tick passes over the pcb_t layout used by the scheduler: a
+ * queue_t walked pcb by pcb through the slab, and the timing wheel that holds
+ * the blocked pcbs, which only touches the pcbs that wake up.
+ *
+ * Run like: ./bench_pcb [passes]
+ */
+
+#define SLICE_MS 500
+
+static uint32_t random_time_ms(void) {
+    return TICKS_MS + (uint32_t) (rand() % 5000);
+}
+
+// Linked-list layout: count down every blocked pcb, re-arm the ones that expire
+static uint32_t list_decrement(queue_t *q) {
+    uint32_t expired = 0;
+    for (pcb_t *pcb = queue_head(q); pcb != NULL; pcb = queue_next(pcb)) {
+        pcb->time_ms = (pcb->time_ms > TICKS_MS) ? pcb->time_ms - TICKS_MS : 0;
+        if (pcb->time_ms == 0) {
+            pcb->time_ms = random_time_ms();
+            expired++;
+        }
+    }
+    return expired;
+}
+
+// Linked-list layout: account a tick to every running pcb, reset the ones whose time is up
+static uint32_t list_account(queue_t *q) {
+    uint32_t expired = 0;
+    for (pcb_t *pcb = queue_head(q); pcb != NULL; pcb = queue_next(pcb)) {
+        pcb->ellapsed_time_ms += TICKS_MS;
+        pcb->slice_time += TICKS_MS;
+        if (pcb->ellapsed_time_ms >= pcb->time_ms || pcb->slice_time >= SLICE_MS) {
+            pcb->ellapsed_time_ms = pcb->slice_time = 0;
+            expired++;
+        }
+    }
+    return expired;
+}
+
+// Timing wheel: advance one tick, re-arm the pcbs that wake up
+static uint32_t wheel_advance(timer_wheel_t *tw, uint32_t current_time_ms) {
+    queue_t woken = {.head = PCB_HANDLE_NONE, .tail = PCB_HANDLE_NONE};
+    uint32_t expired = timer_wheel_advance(tw, current_time_ms, &woken);
+    pcb_t *pcb;
+    while ((pcb = dequeue_pcb(&woken)) != NULL) {
+        timer_wheel_add(tw, pcb, current_time_ms + random_time_ms());
+    }
+    return expired;
+}
+
+static void run(uint32_t tasks, int passes) {
+    if (pcb_pool_init(tasks) < 0) exit(EXIT_FAILURE);
+
+    // Enqueue the pcbs in random order, as real queues are not sorted by slab slot
+    pcb_t **pcbs = malloc(tasks * sizeof(pcb_t *));
+    for (uint32_t i = 0; i < tasks; i++) {
+        pcbs[i] = new_pcb((int32_t) i, 0, random_time_ms());
+    }
+    for (uint32_t i = tasks - 1; i > 0; i--) {
+        uint32_t j = (uint32_t) rand() % (i + 1);
+        pcb_t *tmp = pcbs[i];
+        pcbs[i] = pcbs[j];
+        pcbs[j] = tmp;
+    }
+    queue_t q = {.head = PCB_HANDLE_NONE, .tail = PCB_HANDLE_NONE};
+    for (uint32_t i = 0; i < tasks; i++) {
+        enqueue_pcb(&q, pcbs[i]);
+    }
+
+    // Time expired: account a tick to every pcb of a ready queue
+    uint64_t hits = 0;
+    double t0 = now_s();
+    for (int i = 0; i < passes; i++) {
+        hits += list_account(&q);
+    }
+    double t1 = now_s();
+    printf("%8u tasks  %-15s  list: %6.2f ns/task  (expired %llu)\n",
+           tasks, "time expired", (t1 - t0) * 1e9 / ((double) tasks * passes), (unsigned long long) hits);
+
+
+    // Timer decrement: the list walk against the wheel, with the same timers
+    uint64_t list_hits = 0, wheel_hits = 0;
+    t0 = now_s();
+    for (int i = 0; i < passes; i++) {
+        list_hits += list_decrement(&q);
+    }
+    t1 = now_s();
+    timer_wheel_t tw;
+    timer_wheel_init(&tw);
+    pcb_t *pcb;
+    while ((pcb = dequeue_pcb(&q)) != NULL) {
+        timer_wheel_add(&tw, pcb, pcb->time_ms);
+    }
+    double t2 = now_s();
+    for (int i = 1; i <= passes; i++) {
+        wheel_hits += wheel_advance(&tw, (uint32_t) i * TICKS_MS);
+    }
+    double t3 = now_s();
+    double list_ns = (t1 - t0) * 1e9 / ((double) tasks * passes);
+    double wheel_ns = (t3 - t2) * 1e9 / ((double) tasks * passes);
+    printf("%8u tasks  %-15s  list: %6.2f ns/task  wheel: %6.2f ns/task  speedup %5.1fx  (expired %llu/%llu)\n",
+           tasks, "timer decrement", list_ns, wheel_ns, list_ns / wheel_ns,
+           (unsigned long long) list_hits, (unsigned long long) wheel_hits);
+
+    free(pcbs);
+    pcb_pool_destroy();
+}
+
+int main(int argc, char *argv[]) {
+    int passes = (argc > 1) ? atoi(argv[1]) : 50;
+    if (passes <= 0) {
+        printf("Usage: %s [passes]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    srand(42);
+    run(100000, passes);
+    run(1000000, passes);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,301 @@
+#include "burst_dsl.h"
+
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util.h"
+
+#define MAX_LINE_LEN 1024
+
+typedef enum {
+    FIELD_CONST = 0,
+    FIELD_EXP,                      // exp(mean)
+    FIELD_UNIFORM                   // uniform(lo,hi)
+} field_kind_en;
+
+typedef struct {
+    field_kind_en kind;
+    long long a;                    // Value, mean or lo
+    long long b;                    // hi
+} field_t;
+
+typedef enum {
+    OP_BURST = 0,                   // Generate one burst
+    OP_REPEAT,                      // Start of a repeat block
+    OP_END                          // End of a repeat block
+} op_en;
+
+typedef struct {
+    op_en op;
+    field_t burst_time;             // OP_BURST
+    field_t block_time;
+    field_t nice;
+    page_info_t pages;
+    uint64_t count;                 // OP_REPEAT: iterations
+    size_t jump;                    // OP_REPEAT: its OP_END, OP_END: its OP_REPEAT
+} dsl_op_t;
+
+struct burst_dsl_st {
+    dsl_op_t *ops;
+    size_t count;
+    size_t pc;                      // Next op to run
+    uint64_t left[BURST_DSL_MAX_DEPTH];  // Iterations left of the open repeat blocks
+    int depth;
+    uint64_t rng;                   // State of the random generator
+};
+
+static int starts_with_word(const char *p, const char *eol, const char *word) {
+    size_t len = strlen(word);
+    return (size_t) (eol - p) >= len && memcmp(p, word, len) == 0 &&
+           ((size_t) (eol - p) == len || isspace((unsigned char) p[len]));
+}
+
+int burst_dsl_line(const char *line, const char *eol) {
+    return starts_with_word(line, eol, "seed") || starts_with_word(line, eol, "repeat") ||
+           (line < eol && *line == '}') || memchr(line, '(', (size_t) (eol - line)) != NULL;
+}
+
+static long long sample(const field_t *f, uint64_t *rng) {
+    switch (f->kind) {
+        case FIELD_EXP: {
+            double v = -(double) f->a * log(1.0 - rng_uniform01(rng));
+            return (v >= INT_MAX) ? INT_MAX : llround(v);
+        }
+        case FIELD_UNIFORM:
+            return f->a + (long long) (rng_next(rng) % (uint64_t) (f->b - f->a + 1));
+        default:
+            return f->a;
+    }
+}
+
+static const char *skip_spaces(const char *p) {
+    while (*p == ' ' || *p == '\t' || *p == '\r') p++;
+    return p;
+}
+
+static int parse_number(const char **pp, long long min, long long max, long long *value) {
+    const char *p = skip_spaces(*pp);
+    if (!isdigit((unsigned char) *p) && *p != '-' && *p != '+') return -1;
+    char *end;
+    long long v = strtoll(p, &end, 10);
+    if (end == p || v < min || v > max) return -1;
+    *pp = skip_spaces(end);
+    *value = v;
+    return 0;
+}
+
+// number | exp(mean) | uniform(lo,hi)
+static int parse_field(const char **pp, long long min, long long max, field_t *f) {
+    const char *p = skip_spaces(*pp);
+    if (strncmp(p, "exp(", 4) == 0) {
+        p += 4;
+        f->kind = FIELD_EXP;
+        if (min < 0) min = 0;   // distribuições só geram tempos não negativos
+        if (parse_number(&p, min, max, &f->a) < 0 || *p++ != ')') return -1;
+    } else if (strncmp(p, "uniform(", 8) == 0) {
+        p += 8;
+        f->kind = FIELD_UNIFORM;
+        if (parse_number(&p, min, max, &f->a) < 0 || *p++ != ',' ||
+            parse_number(&p, f->a, max, &f->b) < 0 || *p++ != ')') return -1;
+    } else {
+        f->kind = FIELD_CONST;
+        return parse_number(pp, min, max, &f->a);
+    }
+    *pp = skip_spaces(p);
+    return 0;
+}
+
+// burst[,block[,nice]][,[page,page,...]], same as a plain burst line but any field may be random
+static int parse_burst(const char *p, dsl_op_t *op) {
+    if (parse_field(&p, 0, INT_MAX, &op->burst_time) < 0) return -1;
+    field_t *optional[] = {&op->block_time, &op->nice};
+    for (int i = 0; i < 2 && *p == ','; i++) {
+        if (*skip_spaces(p + 1) == '[') break;
+        p++;
+        if (parse_field(&p, INT_MIN, INT_MAX, optional[i]) < 0) return -1;
+    }
+    if (*p == ',') {
+        p = skip_spaces(p + 1);
+        if (*p++ != '[') return -1;
+        p = skip_spaces(p);
+        while (*p != ']') {
+            long long page;
+            if (parse_number(&p, 0, INT_MAX, &page) < 0) return -1;
+            if (op->pages.count < MAX_PAGES) op->pages.ids[op->pages.count++] = (uint32_t) page;
+            if (*p == ',') p++;
+        }
+        p = skip_spaces(p + 1);
+    }
+    return (*p == '\0') ? 0 : -1;
+}
+
+static uint64_t mul_sat(uint64_t a, uint64_t b) {
+    return (b != 0 && a > UINT64_MAX / b) ? UINT64_MAX : a * b;
+}
+
+// Compile one line (trimmed) into the ops of dsl; line_no is for the error messages
+static int compile_line(burst_dsl_t *dsl, size_t *cap, const char *line, int line_no,
+                        size_t *open, int *emits, uint64_t *mult, uint64_t *total) {
+    if (dsl->count == *cap) {
+        *cap = *cap ? *cap * 2 : 16;
+        dsl_op_t *ops = realloc(dsl->ops, *cap * sizeof(dsl_op_t));
+        if (!ops) {
+            perror("realloc");
+            return -1;
+        }
+        dsl->ops = ops;
+    }
+    dsl_op_t *op = &dsl->ops[dsl->count];
+    *op = (dsl_op_t) {0};
+    const char *p = line;
+    long long value;
+
+    if (starts_with_word(p, p + strlen(p), "seed")) {
+        p += 4;
+        char *end;
+        dsl->rng = strtoull(skip_spaces(p), &end, 10);
+        if (*skip_spaces(end) != '\0') {
+            fprintf(stderr, "Line %d: expected seed <number>\n", line_no);
+            return -1;
+        }
+        return 0;   // não gera nenhuma op
+    }
+    if (starts_with_word(p, p + strlen(p), "repeat")) {
+        p += 6;
+        if (parse_number(&p, 0, LLONG_MAX, &value) < 0 || *p++ != '{' || *skip_spaces(p) != '\0') {
+            fprintf(stderr, "Line %d: expected repeat <count> {\n", line_no);
+            return -1;
+        }
+        if (dsl->depth == BURST_DSL_MAX_DEPTH) {
+            fprintf(stderr, "Line %d: more than %d nested repeat blocks\n", line_no, BURST_DSL_MAX_DEPTH);
+            return -1;
+        }
+        op->op = OP_REPEAT;
+        op->count = (uint64_t) value;
+        open[dsl->depth] = dsl->count;
+        emits[++dsl->depth] = 0;
+        mult[dsl->depth] = mul_sat(mult[dsl->depth - 1], op->count);
+    } else if (*p == '}') {
+        if (*skip_spaces(p + 1) != '\0' || dsl->depth == 0) {
+            fprintf(stderr, "Line %d: unexpected }\n", line_no);
+            return -1;
+        }
+        // Um bloco sem bursts repetiria sem gerar nada
+        if (!emits[dsl->depth]) {
+            fprintf(stderr, "Line %d: repeat block without bursts\n", line_no);
+            return -1;
+        }
+        size_t start = open[--dsl->depth];
+        if (dsl->ops[start].count > 0) emits[dsl->depth] = 1;
+        op->op = OP_END;
+        op->jump = start;
+        dsl->ops[start].jump = dsl->count;
+    } else {
+        op->op = OP_BURST;
+        if (parse_burst(p, op) < 0) {
+            fprintf(stderr, "Line %d: malformed burst: %s\n", line_no, line);
+            return -1;
+        }
+        emits[dsl->depth] = 1;
+        *total = (*total > UINT64_MAX - mult[dsl->depth]) ? UINT64_MAX : *total + mult[dsl->depth];
+    }
+    dsl->count++;
+    return 0;
+}
+
+burst_dsl_t *burst_dsl_compile(const char *data, size_t size, uint64_t *total) {
+    burst_dsl_t *dsl = calloc(1, sizeof(burst_dsl_t));
+    if (!dsl) {
+        perror("calloc");
+        return NULL;
+    }
+    dsl->rng = 1;
+    size_t cap = 0;
+    size_t open[BURST_DSL_MAX_DEPTH];           // Op of each open repeat block
+    int emits[BURST_DSL_MAX_DEPTH + 1] = {0};   // The block generates bursts
+    uint64_t mult[BURST_DSL_MAX_DEPTH + 1] = {1};   // Times the lines at each depth run
+    *total = 0;
+
+    const char *end = data + size;
+    int line_no = 0;
+    int ret = 0;
+    for (const char *line = data; line < end && ret == 0; ) {
+        const char *eol = memchr(line, '\n', (size_t) (end - line));
+        if (!eol) eol = end;
+        line_no++;
+        const char *p = line;
+        while (p < eol && isspace((unsigned char) *p)) p++;
+        const char *q = eol;
+        while (q > p && isspace((unsigned char) q[-1])) q--;
+        if (p < q && *p != '#') {
+            char buf[MAX_LINE_LEN];
+            if ((size_t) (q - p) >= sizeof(buf)) {
+                fprintf(stderr, "Line %d: too long\n", line_no);
+                ret = -1;
+            } else {
+                memcpy(buf, p, (size_t) (q - p));
+                buf[q - p] = '\0';
+                char *comment = strchr(buf, '#');
+                if (comment) {
+                    while (comment > buf && isspace((unsigned char) comment[-1])) comment--;
+                    *comment = '\0';
+                }
+                ret = compile_line(dsl, &cap, buf, line_no, open, emits, mult, total);
+            }
+        }
+        line = eol + 1;
+    }
+    if (ret == 0 && dsl->depth > 0) {
+        fprintf(stderr, "Line %d: missing } of repeat block\n", line_no);
+        ret = -1;
+    }
+    if (ret < 0) {
+        burst_dsl_free(dsl);
+        return NULL;
+    }
+    dsl->depth = 0;
+    return dsl;
+}
+
+int burst_dsl_next(burst_dsl_t *dsl, burst_t *burst) {
+    while (dsl->pc < dsl->count) {
+        const dsl_op_t *op = &dsl->ops[dsl->pc];
+        switch (op->op) {
+            case OP_BURST:
+                burst->burst_time_ms = (uint32_t) sample(&op->burst_time, &dsl->rng);
+                burst->block_time_ms = (uint32_t) sample(&op->block_time, &dsl->rng);
+                burst->nice = (int) sample(&op->nice, &dsl->rng);
+                burst->pages.count = op->pages.count;
+                memcpy(burst->pages.ids, op->pages.ids, op->pages.count * sizeof(uint32_t));
+                dsl->pc++;
+                return 1;
+            case OP_REPEAT:
+                if (op->count == 0) {
+                    dsl->pc = op->jump + 1;     // salta o bloco
+                } else {
+                    dsl->left[dsl->depth++] = op->count;
+                    dsl->pc++;
+                }
+                break;
+            case OP_END:
+                if (--dsl->left[dsl->depth - 1] > 0) {
+                    dsl->pc = op->jump + 1;     // próxima iteração
+                } else {
+                    dsl->depth--;
+                    dsl->pc++;
+                }
+                break;
+        }
+    }
+    return 0;
+}
+
+void burst_dsl_free(burst_dsl_t *dsl) {
+    if (!dsl) return;
+    free(dsl->ops);
+    free(dsl);
+}
@@ -0,0 +1,65 @@
+#ifndef BURST_DSL_H
+#define BURST_DSL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "burst_queue.h"
+
+/*
+ * Burst files may describe their bursts compactly instead of listing them:
+ *
+ *   seed 42                          # seed of the random fields (1 by default)
+ *   repeat 1000 {                    # the lines up to the matching '}', 1000 times
+ *     200,2000
+ *     exp(200),uniform(100,300)      # random CPU and block times
+ *     repeat 3 {
+ *       10,5,0,[1,2,3]
+ *     }
+ *   }
+ *
+ * Any field of a burst line (CPU time, block time, nice) may be a number,
+ * exp(mean) (exponentially distributed, rounded to the nearest integer) or
+ * uniform(lo,hi) (an integer from lo to hi). The file is compiled into a small
+ * program, and the bursts are generated one at a time as they are dequeued, so a
+ * workload of millions of bursts takes a few lines and no memory per burst. The
+ * same seed always generates the same bursts.
+ */
+
+#define BURST_DSL_MAX_DEPTH 16      // Maximum nesting of repeat blocks
+
+typedef struct burst_dsl_st burst_dsl_t;
+
+/**
+ * @brief Whether a line of a burst file needs the compact syntax (a directive or a random field)
+ *
+ * @param line The line, after the leading whitespace
+ * @param eol The end of the line
+ */
+int burst_dsl_line(const char *line, const char *eol);
+
+/**
+ * @brief Compile a burst file that uses the compact syntax
+ *
+ * @param data The contents of the file
+ * @param size The size of the file
+ * @param total Receives the number of bursts the program generates (saturated at UINT64_MAX)
+ * @return The program, or NULL if the file has an error (printed with its line number)
+ */
+burst_dsl_t *burst_dsl_compile(const char *data, size_t size, uint64_t *total);
+
+/**
+ * @brief Generate the next burst of a program
+ *
+ * @param dsl The program
+ * @param burst Receives the burst
+ * @return 1 if a burst was generated, 0 at the end of the program
+ */
+int burst_dsl_next(burst_dsl_t *dsl, burst_t *burst);
+
+/**
+ * @brief Release a program
+ */
+void burst_dsl_free(burst_dsl_t *dsl);
+
+#endif //BURST_DSL_H
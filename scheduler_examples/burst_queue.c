@@ -1,156 +1,431 @@
-#include <ctype.h>
 #include <stdint.h>
 
 #include "burst_queue.h"
+#include "burst_dsl.h"
+#include "util.h"
+#include "workload.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-#define MAX_LINE_LEN 1024
+#define INITIAL_CAPACITY 64
 
-int parse_burst_line(const char* line, burst_t* burst) {
-    if (!line || !burst) return -1;
+// Define a burst file read in chunks through a bounded buffer
+typedef struct burst_stream_st {
+    int fd;
+    char *buf;                      // Bytes read and not parsed yet are buf[pos..len)
+    size_t pos;
+    size_t len;
+    off_t offset;                   // File offset of buf[len]
+    int eof;                        // Nothing left to read
+    int skipping;                   // Discarding a line longer than the buffer
+} burst_stream_t;
 
-    char* line_copy = strdup(line);
-    if (!line_copy) return -1;
+// Make room for one more burst; grows geometrically, so appending stays O(1) amortized
+static int reserve(burst_queue_t *q) {
+    if (q->count < q->capacity) return 0;
+    size_t capacity = q->capacity ? q->capacity * 2 : INITIAL_CAPACITY;
+    burst_t *bursts = realloc(q->bursts, capacity * sizeof(burst_t));
+    if (!bursts) return -1;
+    q->bursts = bursts;
+    q->capacity = capacity;
+    return 0;
+}
 
-    char* endptr;
-    char* token = strtok(line_copy, ",");
+static const char *skip_blanks(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+    return p;
+}
 
-    // Parse required burst_time_ms
-    if (!token) {
-        fprintf(stderr, "Missing burst time\n");
-        free(line_copy);
-        return -1;
+// Parse a decimal integer in place, without copying the line
+static int parse_int(const char **pp, const char *end, long long min, long long max, long long *value) {
+    const char *p = skip_blanks(*pp, end);
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+    if (p == end || *p < '0' || *p > '9') return -1;
+    long long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (*p++ - '0');
+        if (v > (long long) INT_MAX + 1) return -1;   // overflow: fora de qualquer intervalo aceite
     }
+    if (negative) v = -v;
+    if (v < min || v > max) return -1;
+    *pp = skip_blanks(p, end);
+    *value = v;
+    return 0;
+}
 
-    long burst_time = strtol(token, &endptr, 10);
-    if (*endptr != '\0' || burst_time < 0 || burst_time > INT_MAX) {
-        fprintf(stderr, "Invalid burst time: %s\n", token);
-        free(line_copy);
-        return -1;
-    }
-    burst->burst_time_ms = (int)burst_time;
+// Parse one line (without its '\n') into a burst
+static int parse_burst_line(const char *p, const char *end, burst_t *burst) {
+    long long v;
+    if (parse_int(&p, end, 0, INT_MAX, &v) < 0) return -1;
+    burst->burst_time_ms = (uint32_t) v;
 
-    // Optional: block time
-    token = strtok(NULL, ",\r\n");
-    if (token) {
-        long block_time_ms = strtol(token, &endptr, 10);
-        if (*endptr != '\0' || block_time_ms < INT_MIN || block_time_ms > INT_MAX) {
-            fprintf(stderr, "Invalid block time value: %s\n", token);
-            free(line_copy);
-            return -1;
+    // Optional: block time and nice
+    for (int field = 0; field < 2 && p < end && *p == ','; field++) {
+        const char *q = skip_blanks(p + 1, end);
+        if (q < end && *q == '[') break;    // a lista de páginas vem a seguir
+        p = q;
+        if (parse_int(&p, end, INT_MIN, INT_MAX, &v) < 0) return -1;
+        if (field == 0) {
+            burst->block_time_ms = (uint32_t) v;
+        } else {
+            burst->nice = (int) v;
         }
-        burst->block_time_ms = (int)block_time_ms;
     }
 
-    // Optional: parse nice
-    token = strtok(NULL, ",\r\n");
-    if (token) {
-        long nice_value = strtol(token, &endptr, 10);
-        if (*endptr != '\0' || nice_value < INT_MIN || nice_value > INT_MAX) {
-            fprintf(stderr, "Invalid nice value: %s\n", token);
-            free(line_copy);
-            return -1;
+    // Optional: pages list, [page,page,...]
+    burst->pages.count = 0;
+    if (p < end && *p == ',') {
+        p = skip_blanks(p + 1, end);
+        if (p == end || *p != '[') return -1;
+        p = skip_blanks(p + 1, end);
+        while (p < end && *p != ']') {
+            if (parse_int(&p, end, 0, INT_MAX, &v) < 0) return -1;
+            if (burst->pages.count < MAX_PAGES) burst->pages.ids[burst->pages.count++] = (uint32_t) v;
+            if (p < end && *p == ',') p++;
         }
-        burst->nice = (int)nice_value;
+        if (p == end) return -1;    // falta o ']'
+        p = skip_blanks(p + 1, end);
     }
+    return (p == end) ? 0 : -1;
+}
 
-
-    // Optional: parse pages list
-    burst->pages.count = 0;
-    token = strtok(NULL, "[");
-    if (token) token = strtok(NULL, "]");
-    if (token) {
-        char* page_token = strtok(token, ",");
-        while (page_token &&  burst->pages.count< MAX_PAGES) {
-            long page = strtol(page_token, &endptr, 10);
-            if (*endptr != '\0' || page < 0 || page > INT_MAX) {
-                fprintf(stderr, "Invalid page number: %s\n", page_token);
-                free(line_copy);
-                return -1;
-            }
-            burst->pages.ids[burst->pages.count++] = (int)page;
-            page_token = strtok(NULL, ",");
+// Keep a binary workload mapped in an empty queue, or decode it after the bursts already queued
+static int load_binary(burst_queue_t *queue, const workload_header_t *binary, size_t size) {
+    if (binary->count > INT_MAX) {
+        munmap((void *) binary, size);
+        return -1;
+    }
+    if (queue->count == 0 && !queue->binary && !queue->stream && !queue->dsl) {
+        free_burst_queue(queue);
+        *queue = (burst_queue_t) {.binary = binary, .binary_size = size, .count = binary->count};
+        return (int) binary->count;
+    }
+    int success_count = 0;
+    for (size_t i = 0; i < binary->count; i++) {
+        if (reserve(queue) < 0) {
+            fprintf(stderr, "Queue full or allocation failed\n");
+            break;
+        }
+        if (workload_decode(binary, i, &queue->bursts[queue->count]) < 0) {
+            fprintf(stderr, "Skipping corrupted burst %zu\n", i);
+            continue;
         }
+        queue->count++;
+        success_count++;
     }
-
-    free(line_copy);
-    return 0;
+    munmap((void *) binary, size);
+    return success_count;
 }
 
+// Compile a burst file with the compact syntax; an empty queue then generates the bursts as they are dequeued
+static int load_dsl(burst_queue_t *queue, const char *data, size_t size) {
+    uint64_t total;
+    burst_dsl_t *dsl = burst_dsl_compile(data, size, &total);
+    if (!dsl) return -1;
+    if (queue->count == 0 && !queue->binary && !queue->stream && !queue->dsl) {
+        free_burst_queue(queue);
+        queue->dsl = dsl;
+        return (total > INT_MAX) ? INT_MAX : (int) total;
+    }
+    int success_count = 0;
+    for (;;) {
+        if (reserve(queue) < 0) {
+            fprintf(stderr, "Queue full or allocation failed\n");
+            break;
+        }
+        if (!burst_dsl_next(dsl, &queue->bursts[queue->count])) break;
+        queue->count++;
+        success_count++;
+    }
+    burst_dsl_free(dsl);
+    return success_count;
+}
 
-int read_queue_from_file(burst_queue_t* queue, const char* filename) {
+int read_queue_from_file_stats(burst_queue_t* queue, const char* filename, burst_parse_stats_t *stats) {
     if (!queue || !filename) return -1;
+    double start = now_s();
 
-    FILE* file = fopen(filename, "r");
-    if (!file) {
-        perror("fopen");
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror("open");
         return -1;
     }
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t) st.st_size;
+    const char *data = NULL;
+    if (size > 0) {
+        data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            perror("mmap");
+            close(fd);
+            return -1;
+        }
+        madvise((void *) data, size, MADV_SEQUENTIAL);
+    }
+    close(fd);  // o mapeamento continua válido
 
-    char line[MAX_LINE_LEN];
-    int success_count = 0;
-
-    while (fgets(line, sizeof(line), file)) {
-        // Trim leading whitespace
-        char* trimmed = line;
-        while (isspace(*trimmed)) ++trimmed;
+    const workload_header_t *binary = workload_check(data, size);
+    if (binary) {
+        int loaded = load_binary(queue, binary, size);
+        if (stats) {
+            stats->bytes = size;
+            stats->seconds = now_s() - start;
+        }
+        return loaded;
+    }
 
-        if (*trimmed == '#' || *trimmed == '\0') continue;
+    int success_count = 0;
+    const char *end = data + size;
+    for (const char *line = data; line < end; ) {
+        const char *eol = memchr(line, '\n', (size_t) (end - line));
+        if (!eol) eol = end;
+        const char *p = skip_blanks(line, eol);     // Trim leading whitespace
 
-        burst_t burst = {0}; // Initialize burst structure
-        if (parse_burst_line(trimmed, &burst) == 0) {
-            if (enqueue_burst(queue, &burst)) {
-                success_count++;
-            } else {
+        if (p < eol && *p != '#') {
+            // Parse straight into the next free slot, it only counts once the line is valid
+            if (reserve(queue) < 0) {
                 fprintf(stderr, "Queue full or allocation failed\n");
                 break;
             }
-        } else {
-            fprintf(stderr, "Skipping malformed line: %s", line);
+            burst_t *burst = &queue->bursts[queue->count];
+            burst->block_time_ms = 0;
+            burst->nice = 0;
+            if (parse_burst_line(p, eol, burst) == 0) {
+                queue->count++;
+                success_count++;
+            } else if (burst_dsl_line(p, eol)) {
+                // The file uses the compact syntax: compile all of it instead
+                queue->count -= (size_t) success_count;
+                success_count = load_dsl(queue, data, size);
+                break;
+            } else {
+                fprintf(stderr, "Skipping malformed line: %.*s\n", (int) (eol - line), line);
+            }
         }
+        line = eol + 1;
     }
 
-    fclose(file);
+    if (data) munmap((void *) data, size);
+    if (stats) {
+        stats->bytes = size;
+        stats->seconds = now_s() - start;
+    }
     return success_count;
 }
 
+int read_queue_from_file(burst_queue_t* queue, const char* filename) {
+    return read_queue_from_file_stats(queue, filename, NULL);
+}
 
-int enqueue_burst(burst_queue_t* q, const burst_t* burst) {
-    burst_node_t* node = malloc(sizeof(burst_node_t));
-    if (!node) return 0;
+// Read the next chunk after the bytes still unparsed, and ask the kernel to read the one after ahead of use
+static void stream_fill(burst_stream_t *s) {
+    if (s->pos > 0) {
+        memmove(s->buf, s->buf + s->pos, s->len - s->pos);
+        s->len -= s->pos;
+        s->pos = 0;
+    }
+    if (s->len == BURST_STREAM_BUFFER) {
+        fprintf(stderr, "Skipping line longer than %d bytes\n", BURST_STREAM_BUFFER);
+        s->len = 0;
+        s->skipping = 1;
+    }
+    ssize_t n;
+    do {
+        n = read(s->fd, s->buf + s->len, BURST_STREAM_BUFFER - s->len);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+        if (n < 0) perror("read");
+        s->eof = 1;
+        return;
+    }
+    s->len += (size_t) n;
+    s->offset += n;
+    posix_fadvise(s->fd, s->offset, BURST_STREAM_BUFFER, POSIX_FADV_WILLNEED);
+    if (s->skipping) {
+        const char *nl = memchr(s->buf, '\n', s->len);
+        if (nl) {
+            s->pos = (size_t) (nl - s->buf) + 1;
+            s->skipping = 0;
+        } else {
+            s->len = 0;
+        }
+    }
+}
 
-    node->burst = malloc(sizeof(burst_t));
-    if (!node->burst) {
-        free(node);
-        return 0;
+// Next complete line of the stream, without its '\n'; returns 0 at the end of the file
+static int stream_next_line(burst_stream_t *s, const char **line, const char **eol) {
+    for (;;) {
+        const char *start = s->buf + s->pos;
+        const char *nl = memchr(start, '\n', s->len - s->pos);
+        if (nl || (s->eof && s->pos < s->len)) {
+            *line = start;
+            *eol = nl ? nl : s->buf + s->len;   // a última linha pode não ter '\n'
+            s->pos = (size_t) (*eol - s->buf) + (nl != NULL);
+            return 1;
+        }
+        if (s->eof) return 0;
+        stream_fill(s);
     }
+}
+
+static void stream_close(burst_stream_t *s) {
+    close(s->fd);
+    free(s->buf);
+    free(s);
+}
 
-    *node->burst = *burst; // Deep copy the struct
-    node->next = NULL;
+int open_burst_stream(burst_queue_t* queue, const char* filename) {
+    if (!queue || !filename) return -1;
+    burst_stream_t *s = calloc(1, sizeof(burst_stream_t));
+    if (!s || !(s->buf = malloc(BURST_STREAM_BUFFER))) {
+        perror("malloc");
+        free(s);
+        return -1;
+    }
+    s->fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (s->fd < 0) {
+        perror("open");
+        free(s->buf);
+        free(s);
+        return -1;
+    }
+    posix_fadvise(s->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    stream_fill(s);
 
-    if (q->tail) {
-        q->tail->next = node;
-    } else {
-        q->head = node;
+    // A binary workload is already decoded on demand from its mapping. The compact
+    // syntax is found by stream_dequeue, at its first line
+    if (s->len >= sizeof(workload_header_t) && ((const workload_header_t *) s->buf)->magic == WORKLOAD_MAGIC) {
+        stream_close(s);
+        return (read_queue_from_file(queue, filename) < 0) ? -1 : 0;
     }
-    q->tail = node;
+    free_burst_queue(queue);
+    queue->stream = s;
+    return 0;
+}
+
+// The stream reached a line with the compact syntax: compile the whole file instead and
+// skip the bursts already parsed (all the lines before that one were plain bursts)
+static burst_t *stream_switch_to_dsl(burst_queue_t *q) {
+    burst_stream_t *s = q->stream;
+    burst_dsl_t *dsl = NULL;
+    struct stat st;
+    if (fstat(s->fd, &st) == 0 && st.st_size > 0) {
+        size_t size = (size_t) st.st_size;
+        const char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, s->fd, 0);
+        if (data != MAP_FAILED) {
+            uint64_t total;
+            dsl = burst_dsl_compile(data, size, &total);
+            munmap((void *) data, size);
+        }
+    }
+    stream_close(s);
+    q->stream = NULL;
+    if (!dsl) return NULL;
+    q->dsl = dsl;
+    for (size_t i = 0; i < q->next; i++) {
+        if (!burst_dsl_next(dsl, &q->current)) return NULL;
+    }
+    if (!burst_dsl_next(dsl, &q->current)) return NULL;
+    q->count++;
+    q->next++;
+    return &q->current;
+}
+
+// Parse the next valid line of a stream into the current burst of the queue
+static burst_t *stream_dequeue(burst_queue_t *q) {
+    const char *line, *eol;
+    while (stream_next_line(q->stream, &line, &eol)) {
+        const char *p = skip_blanks(line, eol);
+        if (p == eol || *p == '#') continue;
+        q->current.block_time_ms = 0;
+        q->current.nice = 0;
+        if (parse_burst_line(p, eol, &q->current) < 0) {
+            if (burst_dsl_line(p, eol)) return stream_switch_to_dsl(q);
+            fprintf(stderr, "Skipping malformed line: %.*s\n", (int) (eol - line), line);
+            continue;
+        }
+        q->count++;
+        q->next++;
+        return &q->current;
+    }
+    return NULL;
+}
+
+int enqueue_burst(burst_queue_t* q, const burst_t* burst) {
+    if (q->binary || q->stream || q->dsl || reserve(q) < 0) return 0;
+    q->bursts[q->count++] = *burst;
     return 1;
 }
 
 burst_t* dequeue_burst(burst_queue_t* q) {
-    if (!q || !q->head) return NULL;
+    if (q && q->stream) return stream_dequeue(q);
+    if (q && q->dsl) {
+        if (!burst_dsl_next(q->dsl, &q->current)) return NULL;
+        q->count++;
+        q->next++;
+        return &q->current;
+    }
+    if (!q || q->next >= q->count) return NULL;
+    if (!q->binary) return &q->bursts[q->next++];
+    if (workload_decode(q->binary, q->next, &q->current) < 0) {
+        fprintf(stderr, "Corrupted burst %zu in binary workload\n", q->next);
+        q->next = q->count;     // não há como continuar a partir daqui
+        return NULL;
+    }
+    q->next++;
+    return &q->current;
+}
+
+const burst_t* burst_queue_get(const burst_queue_t* q, size_t index, burst_t* scratch) {
+    if (q->stream || q->dsl || index >= q->count) return NULL;
+    if (!q->binary) return &q->bursts[index];
+    return (workload_decode(q->binary, index, scratch) == 0) ? scratch : NULL;
+}
 
-    burst_node_t* node = q->head;
-    burst_t* result = node->burst;
+void burst_queue_from_workload(burst_queue_t* q, const struct workload_header_st *binary) {
+    free_burst_queue(q);
+    q->binary = binary;     // binary_size 0: o mapeamento é de quem chama
+    q->count = binary->count;
+}
 
-    q->head = node->next;
-    if (!q->head)
-        q->tail = NULL;
+int burst_queue_expand(burst_queue_t* q) {
+    if (!q->stream && !q->dsl) return 0;
+    burst_queue_t all = {0};
+    burst_t *burst;
+    while ((burst = dequeue_burst(q)) != NULL) {
+        if (!enqueue_burst(&all, burst)) {
+            fprintf(stderr, "Queue full or allocation failed\n");
+            free_burst_queue(&all);
+            return -1;
+        }
+    }
+    free_burst_queue(q);
+    *q = all;
+    return 0;
+}
+
+size_t burst_queue_remaining(const burst_queue_t* q) {
+    return q->count - q->next;
+}
 
-    free(node);
-    return result;
+void free_burst_queue(burst_queue_t* q) {
+    free(q->bursts);
+    if (q->binary && q->binary_size > 0) munmap((void *) q->binary, q->binary_size);
+    if (q->stream) stream_close(q->stream);
+    burst_dsl_free(q->dsl);
+    *q = (burst_queue_t) {0};
 }
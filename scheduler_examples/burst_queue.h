@@ -1,8 +1,13 @@
 #ifndef BURST_QUEUE_H
 #define BURST_QUEUE_H
 
+#include <stddef.h>
+
 #include "msg.h"
 
+// Buffer of a streamed burst file: the longest line it can hold
+#define BURST_STREAM_BUFFER (256 * 1024)
+
 typedef struct {
     uint32_t burst_time_ms;         // Burst time in milliseconds
     uint32_t block_time_ms;         // Burst time in milliseconds
@@ -11,19 +16,122 @@ typedef struct {
 } burst_t;
 
 
-typedef struct burst_node {
-    burst_t *burst;
-    struct burst_node* next;
-} burst_node_t;
-
+// Define the burst queue: one growable array of bursts and a cursor.
+// The bursts are stored contiguously in file order, dequeue_burst just moves the
+// cursor forward. A zero-initialized burst_queue_t is a valid empty queue.
+// A queue loaded from a binary workload (see workload.h) keeps the file mapped
+// instead, and decodes each burst into current when it is dequeued. A streamed
+// queue (open_burst_stream) holds no bursts at all: it parses the next line of the
+// file into current, count is the number of bursts read so far. So does a queue
+// loaded from a file with the compact syntax (see burst_dsl.h), generating them.
 typedef struct burst_queue_st  {
-    burst_node_t* head;
-    burst_node_t* tail;
+    burst_t *bursts;                // Storage of all the bursts
+    size_t count;                   // Number of bursts stored
+    size_t capacity;                // Number of bursts allocated
+    size_t next;                    // Index of the next burst to dequeue
+    const struct workload_header_st *binary;   // The mapped binary workload (NULL for none)
+    size_t binary_size;             // Size of the mapping (0 if it belongs to the caller)
+    struct burst_stream_st *stream; // The burst file being streamed (NULL for none)
+    struct burst_dsl_st *dsl;       // The compiled compact burst file (NULL for none)
+    burst_t current;                // Last burst decoded from the binary workload, the stream or the program
 } burst_queue_t;
 
+// Statistics of a read_queue_from_file_stats call
+typedef struct {
+    size_t bytes;                   // Size of the file
+    double seconds;                 // Time spent mapping and parsing it
+} burst_parse_stats_t;
+
+/**
+ * @brief Append the bursts of a CSV file (or a binary workload) to a queue
+ *
+ * The file is mapped with mmap and its integers are parsed in place. Each line
+ * holds burst_time_ms[,block_time_ms[,nice]][,[page,page,...]]. Empty lines and
+ * lines starting with '#' are skipped, and so are malformed lines (with a message).
+ * A binary workload written by burstc is recognized by its header: loaded into an
+ * empty queue it stays mapped and nothing is parsed up front. A file using the
+ * compact syntax (repeat blocks, random fields) is compiled, and loaded into an
+ * empty queue its bursts are generated as they are dequeued.
+ *
+ * @param queue The queue
+ * @param filename The CSV file
+ * @return The number of bursts read (or to be generated, up to INT_MAX), or -1 on failure
+ */
 int read_queue_from_file(burst_queue_t* queue, const char* filename);
+
+/**
+ * @brief Same as read_queue_from_file, also reporting the parse throughput
+ *
+ * @param stats Receives the size of the file and the time it took
+ */
+int read_queue_from_file_stats(burst_queue_t* queue, const char* filename, burst_parse_stats_t *stats);
+
+/**
+ * @brief Stream the bursts of a CSV file instead of loading them all
+ *
+ * The file is read in chunks of up to BURST_STREAM_BUFFER bytes, and the kernel is
+ * asked (posix_fadvise) to read the next chunk ahead while the current one is parsed,
+ * so memory use does not depend on the length of the file. Any bursts already in the
+ * queue are dropped. A binary workload is mapped as by read_queue_from_file, and a
+ * file found to use the compact syntax (burst_dsl.h) is compiled once the stream
+ * reaches its first such line.
+ *
+ * @param queue The queue
+ * @param filename The burst file
+ * @return 0 on success, -1 on failure
+ */
+int open_burst_stream(burst_queue_t* queue, const char* filename);
+
+/**
+ * @brief Append a burst to a queue (not to a mapped binary workload or a stream)
+ *
+ * @return 1 on success, 0 on failure
+ */
 int enqueue_burst(burst_queue_t* q, const burst_t* burst);
+
+/**
+ * @brief Take the next burst of the queue
+ *
+ * @return The burst (owned by the queue, valid until the next dequeue_burst), or NULL if none is left
+ */
 burst_t* dequeue_burst(burst_queue_t* q);
 
+/**
+ * @brief Make a queue of the bursts of a binary workload mapped by the caller
+ *
+ * Used for the workloads of a trace; the mapping must outlive the queue.
+ *
+ * @param q The queue (any bursts in it are dropped)
+ * @param binary The workload, checked with workload_check or workload_trace_get
+ */
+void burst_queue_from_workload(burst_queue_t* q, const struct workload_header_st *binary);
+
+/**
+ * @brief Turn a streamed or generated queue into one holding all its remaining bursts
+ *
+ * @return 0 on success, -1 if they do not fit in memory
+ */
+int burst_queue_expand(burst_queue_t* q);
+
+/**
+ * @brief Read a burst of the queue without dequeuing it
+ *
+ * @param q The queue
+ * @param index The burst, from 0 to q->count - 1
+ * @param scratch Where a burst of a binary workload is decoded to
+ * @return The burst, or NULL if it is corrupted or the queue is streamed or generated
+ */
+const burst_t* burst_queue_get(const burst_queue_t* q, size_t index, burst_t* scratch);
+
+/**
+ * @brief Number of bursts not dequeued yet (0 for a streamed or generated queue, whose length is not known)
+ */
+size_t burst_queue_remaining(const burst_queue_t* q);
+
+/**
+ * @brief Release the storage of a queue, leaving it empty
+ */
+void free_burst_queue(burst_queue_t* q);
+
 
 #endif //BURST_QUEUE_H
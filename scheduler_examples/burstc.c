@@ -0,0 +1,34 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "burst_queue.h"
+#include "workload.h"
+
+/*
+ * Compiles a burst file into a binary workload, that app-io loads without parsing.
+ *
+ * Run like: ./burstc A-5.csv A-5.bwl && ./app-io A-5.bwl
+ */
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        printf("Usage: %s <burst-file.csv> <workload.bwl>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    burst_queue_t bursts = {0};
+    burst_parse_stats_t stats;
+    if (read_queue_from_file_stats(&bursts, argv[1], &stats) <= 0 || burst_queue_expand(&bursts) < 0) {
+        fprintf(stderr, "Failed to read burst file %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    size_t count = burst_queue_remaining(&bursts);
+    int ret = workload_write(&bursts, argv[2]);
+    free_burst_queue(&bursts);
+    if (ret < 0) {
+        fprintf(stderr, "Failed to write %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+    printf("Compiled %zu bursts from %s (%zu bytes, %.3f ms) into %s\n",
+           count, argv[1], stats.bytes, stats.seconds * 1000.0, argv[2]);
+    return EXIT_SUCCESS;
+}
@@ -1,42 +1,61 @@
 #include "fifo.h"
 
-#include <stdio.h>
 #include <stdlib.h>
 
 #include "msg.h"
-#include <unistd.h>
 
 /**
  * @brief First-In-First-Out (FIFO) scheduling algorithm.
  *
- * This function implements the FIFO scheduling algorithm. If the CPU is not idle it
- * checks if the application is ready and frees the CPU.
- * If the CPU is idle, it selects the next task to run based on the order they were added
- * to the ready queue. The task that has been in the queue the longest is selected to run next.
- *
- * @param current_time_ms The current time in milliseconds.
- * @param rq Pointer to the ready queue containing tasks that are ready to run.
- * @param cpu_task Double pointer to the currently running task. This will be updated
- *                 to point to the next task to run.
+ * This policy implements the FIFO scheduling algorithm. A task keeps the CPU until
+ * it has used all the time it requested. When the CPU is idle, the task that has been
+ * in the ready queue the longest is selected to run next.
  */
-void fifo_scheduler(uint32_t current_time_ms, queue_t *rq, pcb_t **cpu_task) {  // Função de escalonamento FIFO. Recebe tempo atual, fila de prontos e ponteiro duplo para a tarefa no CPU
-    if (*cpu_task) {      // Se existe uma tarefa em execução
-        (*cpu_task)->ellapsed_time_ms += TICKS_MS;    // Incrementa o tempo já executado do processo
-        if ((*cpu_task)->ellapsed_time_ms >= (*cpu_task)->time_ms) {  // Se o tempo executado atingiu o necessário
-            msg_t msg = {   // Monta uma mensagem para sinalizar término
-                .pid = (*cpu_task)->pid,  // PID do processo concluído
-                .request = PROCESS_REQUEST_DONE,   // Indica fim do processo
-                .time_ms = current_time_ms   // Tempo de conclusão
-            };
-            if (write((*cpu_task)->sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {  // Envia a mensagem por socket
-                perror("write");
-            }
-            // Application finished and can be removed (this is FIFO after all)
-            free((*cpu_task));   // Libera a memória do processo finalizado
-            (*cpu_task) = NULL;  // Marca que não há mais tarefa rodando
-        }
-    }
-    if (*cpu_task == NULL) {     // Se o processador está livre (nenhuma tarefa rodando)
-        *cpu_task = dequeue_pcb(rq);   // Retira o próximo processo da fila de prontos e coloca na CPU
-    }
-}
\ No newline at end of file
+
+typedef struct {
+    queue_t ready_queue;    // Tarefas prontas, por ordem de chegada
+} fifo_state_t;
+
+static void *fifo_init(const char *options) {
+    (void) options;
+    return calloc(1, sizeof(fifo_state_t));
+}
+
+static int fifo_enqueue(void *state, pcb_t *pcb, uint32_t current_time_ms) {
+    (void) current_time_ms;
+    fifo_state_t *fifo = state;
+    return enqueue_pcb(&fifo->ready_queue, pcb);     // Chegadas vão para o fim da fila
+}
+
+static pcb_t *fifo_pick_next(void *state, uint32_t current_time_ms) {
+    (void) current_time_ms;
+    fifo_state_t *fifo = state;
+    return dequeue_pcb(&fifo->ready_queue);   // Retira o próximo processo da fila de prontos
+}
+
+static sched_tick_en fifo_tick(void *state, pcb_t *running, uint32_t current_time_ms, uint32_t elapsed_ms) {
+    (void) state;
+    (void) current_time_ms;
+    running->ellapsed_time_ms += elapsed_ms;    // Incrementa o tempo já executado do processo
+    // Application finished and can leave the CPU (this is FIFO after all)
+    return (running->ellapsed_time_ms >= running->time_ms) ? SCHED_TICK_DONE : SCHED_TICK_CONTINUE;
+}
+
+static uint32_t fifo_run_time_left(void *state, const pcb_t *running) {
+    (void) state;
+    return sched_time_left(running);
+}
+
+static void fifo_destroy(void *state) {
+    free(state);
+}
+
+const sched_policy_t fifo_policy = {
+    .name = "FIFO",
+    .init = fifo_init,
+    .enqueue = fifo_enqueue,
+    .pick_next = fifo_pick_next,
+    .tick = fifo_tick,
+    .run_time_left = fifo_run_time_left,
+    .destroy = fifo_destroy,
+};
@@ -1,8 +1,8 @@
 #ifndef FIFO_H
 #define FIFO_H
 
-#include "queue.h"
+#include "sched_policy.h"
 
-void fifo_scheduler(uint32_t current_time_ms, queue_t *rq, pcb_t **cpu_task);
+extern const sched_policy_t fifo_policy;
 
 #endif //FIFO_H
@@ -0,0 +1,58 @@
+#include "heap_queue.h"
+#include "pcb_pool.h"
+
+#include <stdlib.h>
+
+// Strict ordering of the heap: by key, then by arrival order
+static int heap_less(const heap_elem_t *a, const heap_elem_t *b) {
+    if (a->key != b->key) return a->key < b->key;
+    return a->seq < b->seq;
+}
+
+int heap_push(heap_queue_t *q, pcb_t *task, uint32_t key) {
+    if (q->count == q->capacity) {
+        size_t capacity = q->capacity ? q->capacity * 2 : 64;
+        heap_elem_t *elems = realloc(q->elems, capacity * sizeof(heap_elem_t));
+        if (!elems) return 0;
+        q->elems = elems;
+        q->capacity = capacity;
+    }
+    heap_elem_t elem = {.key = key, .pcb = pcb_handle(task), .seq = q->next_seq++};
+
+    // Sift up: move parents down until the new element fits
+    size_t i = q->count++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!heap_less(&elem, &q->elems[parent])) break;
+        q->elems[i] = q->elems[parent];
+        i = parent;
+    }
+    q->elems[i] = elem;
+    return 1;
+}
+
+pcb_t *heap_pop_min(heap_queue_t *q) {
+    if (!q || q->count == 0) return NULL;
+
+    pcb_t *task = pcb_get(q->elems[0].pcb);
+    heap_elem_t last = q->elems[--q->count];
+
+    // Sift down: move the smaller child up until the last element fits
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= q->count) break;
+        if (child + 1 < q->count && heap_less(&q->elems[child + 1], &q->elems[child])) child++;
+        if (!heap_less(&q->elems[child], &last)) break;
+        q->elems[i] = q->elems[child];
+        i = child;
+    }
+    if (q->count > 0) q->elems[i] = last;
+    return task;
+}
+
+void heap_queue_free(heap_queue_t *q) {
+    free(q->elems);
+    q->elems = NULL;
+    q->count = q->capacity = 0;
+}
@@ -0,0 +1,58 @@
+#ifndef HEAP_QUEUE_H
+#define HEAP_QUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "queue.h"
+
+// Define the elements of the heap: the pcb handle, its key and the arrival order
+typedef struct heap_elem_st {
+    uint32_t key;           // Sort key (smallest first)
+    pcb_handle_t pcb;       // Handle of the pcb in the pcb slab
+    uint64_t seq;           // Arrival order, breaks ties between equal keys
+} heap_elem_t;
+
+// Define the priority queue structure, a binary min-heap stored in an array.
+// A zero-initialized heap_queue_t is a valid empty queue.
+typedef struct heap_queue_st {
+    heap_elem_t *elems;
+    size_t count;           // Number of elements in the heap
+    size_t capacity;        // Number of allocated elements
+    uint64_t next_seq;      // Sequence number of the next insertion
+} heap_queue_t;
+
+/**
+ * @brief Insert a pcb into the priority queue
+ *
+ * This function adds a pcb in O(log n). Pcbs with the same key come out
+ * in the order they were inserted.
+ *
+ * @param q The priority queue to which the pcb will be added
+ * @param task The pcb to be added
+ * @param key The sort key of the pcb (the smallest key is dequeued first)
+ * @return The number of pcb enqueued (0 on failure)
+ */
+int heap_push(heap_queue_t *q, pcb_t *task, uint32_t key);
+
+/**
+ * @brief Dequeue the pcb with the smallest key
+ *
+ * This function removes and returns the pcb with the smallest key in O(log n).
+ * Among equal keys, the pcb that was inserted first is returned.
+ *
+ * @param q The priority queue from which the task will be removed
+ * @return The pcb with the smallest key, or NULL if the queue is empty
+ */
+pcb_t *heap_pop_min(heap_queue_t *q);
+
+/**
+ * @brief Release the memory of the priority queue
+ *
+ * The pcbs still in the queue are not freed.
+ *
+ * @param q The priority queue to be released
+ */
+void heap_queue_free(heap_queue_t *q);
+
+#endif //HEAP_QUEUE_H
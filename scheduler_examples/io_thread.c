@@ -0,0 +1,635 @@
+#define _GNU_SOURCE     // accept4()
+
+#include "io_thread.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "debug.h"
+#include "ring.h"
+
+#define MAX_EVENTS 64           // epoll events handled per epoll_wait() call
+#define IO_OUT_BYTES 512        // reply bytes buffered per connection while its socket is full
+#define IO_EVENT_RING 4096      // events in flight from the I/O thread to the tick thread
+
+#define IO_IN_BYTES (sizeof(msg_hdr_t) + sizeof(uint32_t))   // largest fixed-size frame (v2 RUN/BLOCK)
+
+#define EPOLL_TAG_SERVER 0      // epoll data of the listening socket (slot 0 is never used)
+#define EPOLL_TAG_WAKE   UINT32_MAX
+
+// A client connection, owned by the I/O thread
+typedef struct {
+    int fd;                                     // Socket, -1 once the connection is closed
+    uint32_t generation;                        // Generation of the slot (high bits of the id)
+    uint32_t next_free;                         // Next slot in the freelist
+    uint32_t in_len;                            // Bytes of the partial request in in
+    uint8_t version;                            // Protocol version, 0 until the first frame
+    uint8_t skip_ack;                           // The current request asked for MSG_FLAG_NO_ACK (v2)
+    pid_t pid;                                  // pid sent with the HELLO (v2 frames carry none)
+    uint32_t seq;                               // seq of the current request, echoed in its replies (v2)
+    int in_fd;                                  // fd passed with the partial request (SCM_RIGHTS), or -1
+    msg_t frame;                                // Header of the variable-length frame being read
+    unsigned char *payload;                     // Its payload (NULL if not reading one)
+    uint32_t payload_got;                       // Bytes of the payload read so far
+    uint32_t out_len;                           // Bytes waiting in out
+    uint32_t out_batch;                         // Replies queued in out since the last flush
+    uint8_t dirty;                              // In the list of connections to write at the next flush
+    int watch_out;                              // EPOLLOUT is being watched (out is not empty)
+    unsigned char in[IO_IN_BYTES];              // Partial request frame
+    unsigned char out[IO_OUT_BYTES];            // Replies the socket did not take yet
+} io_conn_t;
+
+static struct {
+    int epoll_fd;
+    int wake_fd;                // eventfd: the tick thread queued commands
+    int notify_fd;              // eventfd: events were posted while the tick thread sleeps in io_wait
+    _Atomic int tick_waiting;   // The tick thread sleeps in io_wait
+    int server_fd;
+    int spare_fd;               // Reserved fd, given up to accept and drop a client when out of fds
+    int accept_paused;          // server_fd left the epoll set: out of fds and no spare fd
+    io_conn_t *conns;           // Slots 1..max_conns
+    uint32_t max_conns;
+    uint32_t free_head;         // First free slot (0 if none)
+    mpsc_ring_t *events;        // I/O thread -> tick thread
+    spsc_ring_t *cmds;          // tick thread -> I/O thread
+    int cmds_pending;           // Commands queued since the last io_flush (tick thread)
+    uint32_t *dirty;            // Connections with replies queued since the last flush
+    uint32_t ndirty;
+    uint32_t batch;             // Replies queued since the last flush
+    pthread_t thread;
+} io;
+
+// Counters of the reply batches, written by the I/O thread and read by io_get_stats
+static struct {
+    _Atomic uint64_t batches;
+    _Atomic uint64_t replies;
+    _Atomic uint64_t writes;
+    _Atomic uint32_t max_batch;
+    _Atomic uint32_t max_coalesced;
+    _Atomic uint64_t batch_hist[IO_BATCH_BUCKETS];
+} stats;
+
+static conn_id_t conn_id(uint32_t index) {
+    return (io.conns[index].generation << CONN_INDEX_BITS) | index;
+}
+
+static io_conn_t *conn_get(conn_id_t conn) {
+    uint32_t index = conn_index(conn);
+    if (index == 0 || index > io.max_conns) return NULL;
+    io_conn_t *c = &io.conns[index];
+    return (conn_id(index) == conn) ? c : NULL;
+}
+
+static void drain_commands(void);
+
+static void post_event(conn_id_t conn, io_event_en type, const msg_t *msg, void *data) {
+    io_msg_t ev = {.conn = conn, .type = type, .data = data};
+    if (msg) ev.msg = *msg;
+    while (!mpsc_ring_push(io.events, &ev)) {
+        // The tick thread is behind: keep sending its replies so it can make progress
+        drain_commands();
+        sched_yield();
+    }
+    // Pairs with the fence in io_wait: either it sees the event or we see it waiting
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&io.tick_waiting, memory_order_relaxed) && atomic_exchange(&io.tick_waiting, 0)) {
+        uint64_t one = 1;
+        if (write(io.notify_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) perror("write: eventfd");
+    }
+}
+
+static int epoll_set(int op, int fd, uint32_t events, uint32_t tag) {
+    struct epoll_event ev = {.events = events, .data.u32 = tag};
+    return epoll_ctl(io.epoll_fd, op, fd, &ev);
+}
+
+// Stop polling the listening socket: its pending clients would make epoll_wait return at once
+static void pause_accept(void) {
+    if (io.accept_paused) return;
+    epoll_set(EPOLL_CTL_DEL, io.server_fd, 0, EPOLL_TAG_SERVER);
+    io.accept_paused = 1;
+    fprintf(stderr, "accept: out of file descriptors, not accepting until one is closed\n");
+}
+
+// A fd was closed: take back the spare fd and poll the listening socket again
+static void resume_accept(void) {
+    if (!io.accept_paused) return;
+    if (io.spare_fd < 0) io.spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    if (epoll_set(EPOLL_CTL_ADD, io.server_fd, EPOLLIN, EPOLL_TAG_SERVER) == 0) {
+        io.accept_paused = 0;
+    }
+}
+
+// Forget the partial input of a connection
+static void drop_in_fd(io_conn_t *c) {
+    if (c->in_fd >= 0) close(c->in_fd);
+    c->in_fd = -1;
+    free(c->payload);
+    c->payload = NULL;
+}
+
+// Close the socket of a connection; the slot stays reserved until the tick thread releases it
+static void close_conn(uint32_t index) {
+    io_conn_t *c = &io.conns[index];
+    if (c->fd < 0) return;
+    close(c->fd);   // also drops the socket from the epoll set
+    c->fd = -1;
+    drop_in_fd(c);
+    resume_accept();
+    post_event(conn_id(index), IO_EVENT_CLOSE, NULL, NULL);
+}
+
+static void accept_new_clients(void) {
+    uint32_t dropped = 0;   // clientes recusados por falta de fds
+    for (;;) {
+        int client_fd = accept4(io.server_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);  // aceita cliente
+        if (client_fd < 0) {
+            if (errno == EINTR)        continue;   // interrompido por sinal - tente novamente
+            if (errno == ECONNABORTED) continue;   // handshake abortado -> next
+            if ((errno == EMFILE || errno == ENFILE) && io.spare_fd >= 0) {
+                // Out of fds: the pending client would keep the listening socket readable
+                // forever, so use the reserved fd to accept it and hang up at once
+                close(io.spare_fd);
+                int fd = accept4(io.server_fd, NULL, NULL, SOCK_CLOEXEC);
+                int err = errno;
+                if (fd >= 0) close(fd);
+                io.spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+                if (fd >= 0) {
+                    dropped++;
+                    continue;
+                }
+                // No fd left to drop the next client with, or none to be had at all (ENFILE)
+                if (io.spare_fd < 0 || err == EMFILE || err == ENFILE) pause_accept();
+            } else if (errno == EMFILE || errno == ENFILE) {
+                pause_accept();
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("accept");
+            }
+            if (dropped > 0) fprintf(stderr, "accept: out of file descriptors, dropped %u connections\n", dropped);
+            return;     // No more clients to accept right now
+        }
+        uint32_t index = io.free_head;
+        if (index == 0) {
+            fprintf(stderr, "Too many connections (max %u)\n", io.max_conns);
+            close(client_fd);
+            continue;
+        }
+        io_conn_t *c = &io.conns[index];
+        io.free_head = c->next_free;
+        c->fd = client_fd;
+        c->in_len = c->out_len = c->out_batch = 0;
+        c->in_fd = -1;
+        c->version = 0;
+        c->skip_ack = 0;
+        c->seq = 0;
+        c->watch_out = 0;
+        if (epoll_set(EPOLL_CTL_ADD, client_fd, EPOLLIN | EPOLLRDHUP, index) < 0) {
+            perror("epoll_ctl: client");
+        }
+        DBG("[Scheduler] New client connected: fd=%d\n", client_fd);  // debug
+        post_event(conn_id(index), IO_EVENT_CONNECT, NULL, NULL);
+    }
+}
+
+// Size of the fixed-size frame being read into in (a v2 header says whether a time follows)
+static uint32_t in_frame_len(const io_conn_t *c) {
+    if (c->version < PROTOCOL_V2) return sizeof(msg_t);
+    if (c->in_len < sizeof(msg_hdr_t)) return sizeof(msg_hdr_t);
+    msg_hdr_t hdr;
+    memcpy(&hdr, c->in, sizeof(hdr));
+    if (hdr.type == PROCESS_REQUEST_RUN || hdr.type == PROCESS_REQUEST_BLOCK) {
+        return sizeof(msg_hdr_t) + sizeof(uint32_t);
+    }
+    return sizeof(msg_hdr_t);
+}
+
+// Read from a connection, keeping a file descriptor passed with SCM_RIGHTS
+static ssize_t recv_frame_bytes(io_conn_t *c) {
+    struct iovec iov = {.iov_base = c->in + c->in_len, .iov_len = in_frame_len(c) - c->in_len};
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr mh = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof(control.buf)
+    };
+    ssize_t n = recvmsg(c->fd, &mh, MSG_CMSG_CLOEXEC);
+    if (n <= 0) return n;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&mh); cmsg != NULL; cmsg = CMSG_NXTHDR(&mh, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            drop_in_fd(c);
+            memcpy(&c->in_fd, CMSG_DATA(cmsg), sizeof(int));
+        }
+    }
+    return n;
+}
+
+static void queue_out(uint32_t index, const void *bytes, uint32_t len, const void *data, uint32_t data_len);
+
+// Handle a complete request; a PROCESS_REQUEST_SCRIPT header starts reading its payload
+static int frame_received(uint32_t index, const msg_t *msg) {
+    io_conn_t *c = &io.conns[index];
+    if (c->version == 0) {      // o primeiro frame decide a versão do protocolo
+        c->version = PROTOCOL_V1;
+        c->pid = msg->pid;
+        if (msg->request == PROCESS_REQUEST_HELLO) {
+            drop_in_fd(c);
+            c->version = (msg->time_ms >= PROTOCOL_V2) ? PROTOCOL_V2 : PROTOCOL_V1;
+            msg_t ack = {.pid = msg->pid, .request = PROCESS_REQUEST_ACK, .time_ms = c->version};
+            queue_out(index, &ack, sizeof(ack), NULL, 0);  // the reply to the HELLO is always v1
+            return 0;
+        }
+    }
+    if (msg->request == PROCESS_REQUEST_HELLO) return -1;
+    if (msg->request == PROCESS_REQUEST_SHM) {
+        if (c->version != PROTOCOL_V1) return -1;   // the shared-memory rings only carry msg_t
+        msg_t shm = *msg;
+        shm.time_ms = (uint32_t) c->in_fd;  // the tick thread owns the fd from now on
+        c->in_fd = -1;
+        post_event(conn_id(index), IO_EVENT_SHM, &shm, NULL);
+        return 0;
+    }
+    drop_in_fd(c);
+    if (msg->request == PROCESS_REQUEST_SCRIPT) {
+        if (msg->time_ms == 0 || msg->time_ms > SCRIPT_MAX_BYTES || !(c->payload = malloc(msg->time_ms))) {
+            fprintf(stderr, "Rejected a script of %u bytes\n", msg->time_ms);
+            return -1;
+        }
+        c->frame = *msg;
+        c->payload_got = 0;
+        return 0;
+    }
+    post_event(conn_id(index), IO_EVENT_REQUEST, msg, NULL);
+    return 0;
+}
+
+// Turn a complete v2 frame into a msg_t
+static int frame_received_v2(uint32_t index) {
+    io_conn_t *c = &io.conns[index];
+    msg_hdr_t hdr;
+    memcpy(&hdr, c->in, sizeof(hdr));
+    if (hdr.version != PROTOCOL_V2) return -1;
+    msg_t msg = {.pid = c->pid, .request = hdr.type, .time_ms = hdr.length};
+    if (hdr.type == PROCESS_REQUEST_RUN || hdr.type == PROCESS_REQUEST_BLOCK) {
+        if (hdr.length != sizeof(uint32_t)) return -1;
+        memcpy(&msg.time_ms, c->in + sizeof(hdr), sizeof(uint32_t));
+    } else if (hdr.type != PROCESS_REQUEST_SCRIPT) {
+        return -1;
+    }
+    c->seq = hdr.seq;
+    c->skip_ack = (hdr.flags & MSG_FLAG_NO_ACK) != 0;
+    return frame_received(index, &msg);
+}
+
+// Read every complete frame available on a connection
+static void read_conn(uint32_t index) {
+    io_conn_t *c = &io.conns[index];
+    while (c->fd >= 0) {
+        ssize_t n;
+        if (c->payload) {   // a ler o payload de um frame de tamanho variável
+            n = read(c->fd, c->payload + c->payload_got, c->frame.time_ms - c->payload_got);
+            if (n > 0) {
+                c->payload_got += (uint32_t) n;
+                if (c->payload_got == c->frame.time_ms) {
+                    void *payload = c->payload;
+                    c->payload = NULL;      // the tick thread owns the payload from now on
+                    post_event(conn_id(index), IO_EVENT_SCRIPT, &c->frame, payload);
+                }
+                continue;
+            }
+        } else {
+            n = recv_frame_bytes(c);
+            if (n > 0) {
+                c->in_len += (uint32_t) n;
+                if (c->in_len == in_frame_len(c)) {   // frame completo
+                    int ret;
+                    if (c->version >= PROTOCOL_V2) {
+                        ret = frame_received_v2(index);
+                    } else {
+                        msg_t msg;
+                        memcpy(&msg, c->in, sizeof(msg_t));
+                        ret = frame_received(index, &msg);
+                    }
+                    c->in_len = 0;
+                    if (ret < 0) close_conn(index);
+                }
+                continue;
+            }
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            perror("read");
+        } else {
+            DBG("Connection closed by remote host\n");  // n = 0, conexao fechada pelo cliente
+        }
+        close_conn(index);
+    }
+}
+
+// Write the buffered replies of a connection, watching for EPOLLOUT while some are left
+static void write_conn(uint32_t index) {
+    io_conn_t *c = &io.conns[index];
+    uint32_t sent = 0;
+    while (c->fd >= 0 && sent < c->out_len) {
+        ssize_t n = write(c->fd, c->out + sent, c->out_len - sent);
+        atomic_fetch_add_explicit(&stats.writes, 1, memory_order_relaxed);
+        if (n > 0) {
+            sent += (uint32_t) n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            perror("write");
+            close_conn(index);
+            return;
+        }
+    }
+    if (c->fd < 0) return;
+    memmove(c->out, c->out + sent, c->out_len - sent);
+    c->out_len -= sent;
+    int want_out = (c->out_len > 0);
+    if (want_out != c->watch_out) {     // only touch epoll when the socket fills up or drains
+        epoll_set(EPOLL_CTL_MOD, c->fd, EPOLLIN | EPOLLRDHUP | (want_out ? EPOLLOUT : 0), index);
+        c->watch_out = want_out;
+    }
+}
+
+// Append a reply (header bytes and optional payload) to the output of a connection.
+// It is written by flush_out, together with the other replies to the same connection.
+// A batch that fills the buffer (e.g. the DONEs of many empty script bursts) is
+// written at once; only a client whose socket is full as well gets closed.
+static void queue_out(uint32_t index, const void *bytes, uint32_t len, const void *data, uint32_t data_len) {
+    io_conn_t *c = &io.conns[index];
+    if (c->out_len + len + data_len > sizeof(c->out) && !c->watch_out) {
+        write_conn(index);
+        if (c->fd < 0) return;
+    }
+    if (c->out_len + len + data_len > sizeof(c->out)) {
+        fprintf(stderr, "Application on fd %d is not reading its replies, closing it\n", c->fd);
+        close_conn(index);
+        return;
+    }
+    memcpy(c->out + c->out_len, bytes, len);
+    c->out_len += len;
+    if (data_len > 0) {
+        memcpy(c->out + c->out_len, data, data_len);
+        c->out_len += data_len;
+    }
+    c->out_batch++;
+    io.batch++;
+    if (!c->dirty) {
+        c->dirty = 1;
+        io.dirty[io.ndirty++] = index;
+    }
+}
+
+static void stat_max(_Atomic uint32_t *max, uint32_t value) {
+    if (value > atomic_load_explicit(max, memory_order_relaxed)) {
+        atomic_store_explicit(max, value, memory_order_relaxed);    // só a thread de I/O escreve
+    }
+}
+
+// Write the replies queued since the last flush: one write() per connection
+static void flush_out(void) {
+    for (uint32_t i = 0; i < io.ndirty; i++) {
+        io_conn_t *c = &io.conns[io.dirty[i]];
+        c->dirty = 0;
+        stat_max(&stats.max_coalesced, c->out_batch);
+        c->out_batch = 0;
+        // With EPOLLOUT watched the socket is full: the replies go out when it drains
+        if (c->fd >= 0 && !c->watch_out) write_conn(io.dirty[i]);
+    }
+    io.ndirty = 0;
+    if (io.batch == 0) return;
+    uint32_t bucket = 0;
+    while (bucket < IO_BATCH_BUCKETS - 1 && (2u << bucket) <= io.batch) bucket++;   // floor(log2(batch))
+    atomic_fetch_add_explicit(&stats.batch_hist[bucket], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats.batches, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&stats.replies, io.batch, memory_order_relaxed);
+    stat_max(&stats.max_batch, io.batch);
+    io.batch = 0;
+}
+
+static void send_msg(conn_id_t conn, const msg_t *msg, const void *data) {
+    io_conn_t *c = conn_get(conn);
+    if (!c || c->fd < 0) return;     // the application already went away
+    uint32_t index = conn_index(conn);
+    if (c->version < PROTOCOL_V2) {
+        queue_out(index, msg, sizeof(msg_t), data, data ? msg->time_ms : 0);
+        return;
+    }
+    if (msg->request == PROCESS_REQUEST_ACK && c->skip_ack) return;   // a aplicação dispensou o ACK
+    msg_hdr_t hdr = {.version = PROTOCOL_V2, .type = (uint8_t) msg->request, .seq = c->seq};
+    unsigned char frame[IO_IN_BYTES];
+    if (data) {
+        hdr.length = msg->time_ms;
+        queue_out(index, &hdr, sizeof(hdr), data, hdr.length);
+    } else {
+        hdr.length = sizeof(uint32_t);
+        memcpy(frame, &hdr, sizeof(hdr));
+        memcpy(frame + sizeof(hdr), &msg->time_ms, sizeof(uint32_t));
+        queue_out(index, frame, sizeof(frame), NULL, 0);
+    }
+}
+
+static void release_conn(conn_id_t conn) {
+    io_conn_t *c = conn_get(conn);
+    if (!c) return;
+    uint32_t index = conn_index(conn);
+    if (c->fd >= 0) {
+        close(c->fd);
+        c->fd = -1;
+    }
+    drop_in_fd(c);
+    resume_accept();
+    c->generation = (c->generation + 1) & ((1u << (32 - CONN_INDEX_BITS)) - 1);
+    c->next_free = io.free_head;
+    io.free_head = index;
+}
+
+static void drain_commands(void) {
+    io_msg_t cmd;
+    while (spsc_ring_pop(io.cmds, &cmd)) {
+        if (cmd.type == IO_CMD_SEND) {
+            send_msg(cmd.conn, &cmd.msg, cmd.data);
+            free(cmd.data);
+        } else {
+            release_conn(cmd.conn);
+        }
+    }
+    flush_out();
+}
+
+static void *io_thread_main(void *arg) {
+    (void) arg;
+    struct epoll_event events[MAX_EVENTS];
+    for (;;) {
+        int n = epoll_wait(io.epoll_fd, events, MAX_EVENTS, -1);
+        if (n < 0) {
+            if (errno != EINTR) perror("epoll_wait");
+            continue;
+        }
+        for (int i = 0; i < n; i++) {
+            uint32_t tag = events[i].data.u32;
+            if (tag == EPOLL_TAG_SERVER) {
+                accept_new_clients();
+            } else if (tag == EPOLL_TAG_WAKE) {
+                uint64_t count;
+                if (read(io.wake_fd, &count, sizeof(count)) < 0 && errno != EAGAIN) perror("read: eventfd");
+            } else {
+                if (events[i].events & EPOLLOUT) write_conn(tag);
+                if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) read_conn(tag);
+            }
+        }
+        drain_commands();
+    }
+    return NULL;
+}
+
+int io_thread_start(int server_fd, uint32_t max_conns) {
+    if (max_conns == 0 || max_conns > CONN_MAX) {
+        fprintf(stderr, "Invalid number of connections %u (max %u)\n", max_conns, CONN_MAX);
+        return -1;
+    }
+    io.server_fd = server_fd;
+    io.max_conns = max_conns;
+    io.spare_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    io.conns = calloc((size_t) max_conns + 1, sizeof(io_conn_t));
+    io.dirty = calloc(max_conns, sizeof(uint32_t));
+    // Every connection has at most a couple of replies and one release in flight
+    uint32_t cmds_capacity = 1024;
+    while (cmds_capacity < 4 * max_conns) cmds_capacity <<= 1;
+    size_t cmds_bytes = spsc_ring_bytes(cmds_capacity, sizeof(io_msg_t));
+    cmds_bytes = (cmds_bytes + RING_CACHE_LINE - 1) & ~(size_t) (RING_CACHE_LINE - 1);
+    void *cmds_mem = aligned_alloc(RING_CACHE_LINE, cmds_bytes);
+    io.events = mpsc_ring_create(IO_EVENT_RING, sizeof(io_msg_t));
+    if (!io.conns || !io.dirty || !cmds_mem || !io.events) {
+        perror("io_thread_start");
+        return -1;
+    }
+    io.cmds = spsc_ring_init(cmds_mem, cmds_capacity, sizeof(io_msg_t));
+    for (uint32_t i = max_conns; i >= 1; i--) {    // freelist em ordem crescente de slot
+        io.conns[i].fd = -1;
+        io.conns[i].next_free = io.free_head;
+        io.free_head = i;
+    }
+
+    io.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    io.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    io.notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (io.epoll_fd < 0 || io.wake_fd < 0 || io.notify_fd < 0) {
+        perror("epoll_create1/eventfd");
+        return -1;
+    }
+    if (epoll_set(EPOLL_CTL_ADD, server_fd, EPOLLIN, EPOLL_TAG_SERVER) < 0 ||
+        epoll_set(EPOLL_CTL_ADD, io.wake_fd, EPOLLIN, EPOLL_TAG_WAKE) < 0) {
+        perror("epoll_ctl");
+        return -1;
+    }
+    // O thread de I/O herda a máscara: SIGINT/SIGTERM ficam para o tick thread
+    sigset_t stop_signals, old_mask;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, &old_mask);
+    int err = pthread_create(&io.thread, NULL, io_thread_main, NULL);
+    pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+    if (err != 0) {
+        fprintf(stderr, "pthread_create: %s\n", strerror(err));
+        return -1;
+    }
+    return 0;
+}
+
+int io_next_event(io_msg_t *ev) {
+    return mpsc_ring_pop(io.events, ev);
+}
+
+void io_wait(int timer_fd) {
+    atomic_store(&io.tick_waiting, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (!mpsc_ring_empty(io.events)) {
+        atomic_store(&io.tick_waiting, 0);
+        return;
+    }
+    struct pollfd fds[2] = {
+        {.fd = io.notify_fd, .events = POLLIN},
+        {.fd = timer_fd, .events = POLLIN}
+    };
+    if (poll(fds, timer_fd >= 0 ? 2 : 1, -1) < 0 && errno != EINTR) perror("poll");
+    atomic_store(&io.tick_waiting, 0);
+    uint64_t count;
+    if ((fds[0].revents & POLLIN) && read(io.notify_fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        perror("read: eventfd");
+    }
+    if (timer_fd >= 0 && (fds[1].revents & POLLIN) && read(timer_fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        perror("read: timerfd");
+    }
+}
+
+void io_wake(void) {
+    uint64_t one = 1;
+    ssize_t ret = write(io.notify_fd, &one, sizeof(one));     // async-signal-safe
+    (void) ret;
+}
+
+static void push_command(const io_msg_t *cmd) {
+    while (!spsc_ring_push(io.cmds, cmd)) {
+        io.cmds_pending = 1;
+        io_flush();     // full: make sure the I/O thread is draining it
+        sched_yield();
+    }
+    io.cmds_pending = 1;
+}
+
+void io_send(conn_id_t conn, const msg_t *msg) {
+    io_msg_t cmd = {.conn = conn, .type = IO_CMD_SEND, .msg = *msg};
+    push_command(&cmd);
+}
+
+void io_send_frame(conn_id_t conn, const msg_t *msg, void *data) {
+    io_msg_t cmd = {.conn = conn, .type = IO_CMD_SEND, .msg = *msg, .data = data};
+    push_command(&cmd);
+}
+
+void io_release(conn_id_t conn) {
+    io_msg_t cmd = {.conn = conn, .type = IO_CMD_RELEASE};
+    push_command(&cmd);
+}
+
+void io_flush(void) {
+    if (!io.cmds_pending) return;
+    io.cmds_pending = 0;
+    uint64_t one = 1;
+    if (write(io.wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        perror("write: eventfd");
+    }
+}
+
+void io_get_stats(io_stats_t *out) {
+    out->batches = atomic_load_explicit(&stats.batches, memory_order_relaxed);
+    out->replies = atomic_load_explicit(&stats.replies, memory_order_relaxed);
+    out->writes = atomic_load_explicit(&stats.writes, memory_order_relaxed);
+    out->max_batch = atomic_load_explicit(&stats.max_batch, memory_order_relaxed);
+    out->max_coalesced = atomic_load_explicit(&stats.max_coalesced, memory_order_relaxed);
+    for (int i = 0; i < IO_BATCH_BUCKETS; i++) {
+        out->batch_hist[i] = atomic_load_explicit(&stats.batch_hist[i], memory_order_relaxed);
+    }
+}
@@ -0,0 +1,138 @@
+#ifndef IO_THREAD_H
+#define IO_THREAD_H
+
+#include <stdint.h>
+
+#include "msg.h"
+
+// A connection id holds the connection slot in its low CONN_INDEX_BITS bits and the
+// generation of the slot in the remaining high bits, so the id of a connection that
+// was released never matches a new connection in the same slot. Slot 0 is never
+// used, so CONN_ID_NONE is never a valid id.
+typedef uint32_t conn_id_t;
+#define CONN_ID_NONE     0
+#define CONN_INDEX_BITS  20
+#define CONN_INDEX_MASK  ((1u << CONN_INDEX_BITS) - 1)
+#define CONN_MAX         (CONN_INDEX_MASK - 1)
+
+// Events posted by the I/O thread to the tick thread
+typedef enum {
+    IO_EVENT_CONNECT = 0,       // A new application connected
+    IO_EVENT_REQUEST,           // A complete msg_t frame was received
+    IO_EVENT_CLOSE,             // The application went away (the slot is kept until io_release)
+    IO_EVENT_SHM,               // PROCESS_REQUEST_SHM handshake, msg.time_ms holds the received fd (or -1)
+    IO_EVENT_SCRIPT,            // PROCESS_REQUEST_SCRIPT frame, data holds its msg.time_ms bytes of payload
+} io_event_en;
+
+// Commands sent by the tick thread to the I/O thread
+typedef enum {
+    IO_CMD_SEND = 0,            // Send msg (and msg.time_ms bytes of data, if not NULL) to the application
+    IO_CMD_RELEASE,             // Close the connection (if still open) and free its slot
+} io_cmd_en;
+
+#define IO_BATCH_BUCKETS 8        // batch_hist buckets: 1, 2-3, 4-7, ..., 128 or more replies
+
+// Counters of the replies written by the I/O thread. The replies queued by the tick
+// thread up to an io_flush() are written as one batch, with one write() per connection.
+typedef struct {
+    uint64_t batches;           // Batches with at least one reply
+    uint64_t replies;           // Replies written (socket transport)
+    uint64_t writes;            // write() calls on client sockets
+    uint32_t max_batch;         // Most replies in one batch
+    uint32_t max_coalesced;     // Most replies to one connection coalesced into one write()
+    uint64_t batch_hist[IO_BATCH_BUCKETS];  // Batches by number of replies (powers of two)
+} io_stats_t;
+
+// Element of both rings between the threads
+typedef struct {
+    conn_id_t conn;
+    uint32_t type;              // io_event_en or io_cmd_en
+    msg_t msg;
+    void *data;                 // Payload of a variable-length frame (malloc'd, owned by the receiver)
+} io_msg_t;
+
+/**
+ * @brief Start the I/O thread
+ *
+ * The I/O thread owns the server socket and every client socket. It accepts
+ * connections, parses msg_t frames and posts them to the tick thread through an
+ * MPSC ring. Replies come back through an SPSC ring and are written without ever
+ * blocking the tick thread.
+ *
+ * @param server_fd The (non-blocking) listening socket
+ * @param max_conns Maximum number of simultaneous connections (at most CONN_MAX)
+ * @return 0 on success, -1 on failure
+ */
+int io_thread_start(int server_fd, uint32_t max_conns);
+
+/**
+ * @brief Take the next event posted by the I/O thread (tick thread only)
+ *
+ * @param ev Receives the event
+ * @return 1 if an event was taken, 0 if there are none
+ */
+int io_next_event(io_msg_t *ev);
+
+/**
+ * @brief Sleep until the I/O thread posts an event or timer_fd expires (tick thread only)
+ *
+ * Returns at once if events are already waiting. May also return early, e.g.
+ * when a signal arrives, so the caller must check the time again.
+ *
+ * @param timer_fd A timerfd, or -1 to wait for events only
+ */
+void io_wait(int timer_fd);
+
+/**
+ * @brief Make the current or next io_wait return (async-signal-safe)
+ */
+void io_wake(void);
+
+/**
+ * @brief Queue a message to an application (tick thread only)
+ *
+ * The message is handed to the I/O thread at the next io_flush().
+ *
+ * @param conn The connection of the application
+ * @param msg The message
+ */
+void io_send(conn_id_t conn, const msg_t *msg);
+
+/**
+ * @brief Queue a variable-length frame to an application (tick thread only)
+ *
+ * @param conn The connection of the application
+ * @param msg The header, whose time_ms is the payload length
+ * @param data The payload (malloc'd, freed by the I/O thread once it is sent)
+ */
+void io_send_frame(conn_id_t conn, const msg_t *msg, void *data);
+
+/**
+ * @brief Close a connection and free its slot (tick thread only)
+ *
+ * Must be called once for every connection, usually after its IO_EVENT_CLOSE.
+ *
+ * @param conn The connection
+ */
+void io_release(conn_id_t conn);
+
+/**
+ * @brief Wake up the I/O thread if commands were queued since the last flush
+ */
+void io_flush(void);
+
+/**
+ * @brief Read the reply batching counters (any thread)
+ *
+ * @param stats Receives the counters
+ */
+void io_get_stats(io_stats_t *stats);
+
+/**
+ * @brief Slot index of a connection id, below max_conns + 1
+ */
+static inline uint32_t conn_index(conn_id_t conn) {
+    return conn & CONN_INDEX_MASK;
+}
+
+#endif //IO_THREAD_H
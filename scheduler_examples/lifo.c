@@ -0,0 +1,58 @@
+#include <stdlib.h>
+
+#include "sched_policy.h"
+
+/**
+ * @brief Last-In-First-Out (LIFO) scheduling algorithm, built as a policy plugin.
+ *
+ * Example of a policy that lives outside the simulator. It is loaded at run time with
+ * ./scheduler ./lifo.so and only has to export a sched_policy_t named sched_policy.
+ * A task keeps the CPU until it has used all the time it requested. When the CPU is
+ * idle, the task that arrived last is selected to run next.
+ */
+
+typedef struct {
+    queue_t ready_queue;    // Tarefas prontas, a mais recente à cabeça
+} lifo_state_t;
+
+static void *lifo_init(const char *options) {
+    (void) options;
+    return calloc(1, sizeof(lifo_state_t));
+}
+
+static int lifo_enqueue(void *state, pcb_t *pcb, uint32_t current_time_ms) {
+    (void) current_time_ms;
+    lifo_state_t *lifo = state;
+    queue_t arrival = {.head = PCB_HANDLE_NONE, .tail = PCB_HANDLE_NONE};
+    enqueue_pcb(&arrival, pcb);
+    append_queue(&arrival, &lifo->ready_queue);   // A chegada passa para a frente da fila
+    lifo->ready_queue = arrival;
+    return 1;
+}
+
+static pcb_t *lifo_pick_next(void *state, uint32_t current_time_ms) {
+    (void) current_time_ms;
+    lifo_state_t *lifo = state;
+    return dequeue_pcb(&lifo->ready_queue);
+}
+
+static sched_tick_en lifo_tick(void *state, pcb_t *running, uint32_t current_time_ms, uint32_t elapsed_ms) {
+    (void) state;
+    (void) current_time_ms;
+    running->ellapsed_time_ms += elapsed_ms;    // Incrementa o tempo já executado do processo
+    return (running->ellapsed_time_ms >= running->time_ms) ? SCHED_TICK_DONE : SCHED_TICK_CONTINUE;
+}
+
+static void lifo_destroy(void *state) {
+    free(state);
+}
+
+const sched_policy_t sched_policy = {
+    .name = "LIFO",
+    .init = lifo_init,
+    .enqueue = lifo_enqueue,
+    .pick_next = lifo_pick_next,
+    .tick = lifo_tick,
+    .run_time_left = NULL,      // sched_time_left(), não há preempção
+    .destroy = lifo_destroy,
+};
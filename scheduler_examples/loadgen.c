@@ -0,0 +1,378 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "app_proto.h"
+#include "burst_queue.h"
+#include "msg.h"
+#include "util.h"
+#include "workload.h"
+
+/*
+ * Runs many simulated applications from one process. Each application has its
+ * own connection to the scheduler and goes through its bursts exactly like
+ * app-io (same requests, same final line), but all the connections are
+ * non-blocking and driven by one epoll loop, so thousands of applications cost
+ * a few hundred bytes each instead of a process each.
+ *
+ * Applications arrive all at once, at a fixed rate (--rate) or as a Poisson
+ * process (--poisson), whatever the scheduler does (open loop).
+ *
+ * Run like: ./loadgen --copies 1000 --poisson 200 A-5.csv B-5.csv
+ *           ./loadgen out.bwlt
+ */
+
+#define MAX_EVENTS 256
+#define IN_FRAMES 8                 // Replies read at once per connection
+#define RETRY_MS 1                  // Wait before retrying a connection refused with EAGAIN
+
+typedef struct {
+    burst_queue_t bursts;
+    app_state_t state;
+    char *name;
+    pid_t pid;                      // Number of the application, sent as its pid
+    double arrival_s;               // Arrival time, from the start of the run
+    int fd;
+    msg_t out;                      // Request being sent
+    size_t out_sent;
+    unsigned char in[IN_FRAMES * sizeof(msg_t)];
+    size_t in_len;
+} lg_app_t;
+
+static lg_app_t *apps;
+static uint32_t napps, apps_cap;
+static uint32_t finished, failed;
+static int epoll_fd;
+static int quiet;
+
+typedef struct {
+    void *data;
+    size_t size;
+} lg_mapping_t;
+
+static lg_mapping_t *traces;       // Traces mapped for the whole run
+static uint32_t ntraces;
+
+static char *app_name(const char *path, int index) {
+    const char *slash = strrchr(path, '/');
+    const char *base = slash ? slash + 1 : path;
+    const char *dot = strrchr(base, '.');
+    int len = dot ? (int) (dot - base) : (int) strlen(base);
+    char *name = malloc((size_t) len + 16);
+    if (!name) return NULL;
+    if (index < 0) {
+        snprintf(name, (size_t) len + 16, "%.*s", len, base);
+    } else {
+        snprintf(name, (size_t) len + 16, "%.*s#%d", len, base, index);
+    }
+    return name;
+}
+
+static lg_app_t *new_app(const char *path, int index) {
+    if (napps == apps_cap) {
+        uint32_t cap = apps_cap ? apps_cap * 2 : 64;
+        lg_app_t *p = realloc(apps, cap * sizeof(lg_app_t));
+        if (!p) {
+            perror("realloc");
+            return NULL;
+        }
+        apps = p;
+        apps_cap = cap;
+    }
+    lg_app_t *app = &apps[napps];
+    *app = (lg_app_t) {.fd = -1, .pid = (pid_t) napps + 1};
+    if (!(app->name = app_name(path, index))) {
+        perror("malloc");
+        return NULL;
+    }
+    napps++;
+    return app;
+}
+
+// A workload trace gives one application per workload, the mapping is kept for the whole run
+static int load_trace(const char *path, uint32_t copies) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+    struct stat st;
+    void *data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (data == MAP_FAILED) return 0;
+    const workload_trace_t *trace = workload_trace_check(data, (size_t) st.st_size);
+    if (!trace) {
+        munmap(data, (size_t) st.st_size);
+        return 0;   // não é um trace
+    }
+    lg_mapping_t *p = realloc(traces, (ntraces + 1) * sizeof(lg_mapping_t));
+    if (!p) {
+        perror("realloc");
+        munmap(data, (size_t) st.st_size);
+        return -1;
+    }
+    traces = p;
+    traces[ntraces++] = (lg_mapping_t) {.data = data, .size = (size_t) st.st_size};
+    for (uint32_t c = 0; c < copies; c++) {
+        for (uint64_t i = 0; i < trace->count; i++) {
+            const workload_header_t *w = workload_trace_get(trace, (size_t) st.st_size, (size_t) i);
+            if (!w) {
+                fprintf(stderr, "Corrupted workload %llu in %s\n", (unsigned long long) i, path);
+                return -1;
+            }
+            lg_app_t *app = new_app(path, (int) i);
+            if (!app) return -1;
+            burst_queue_from_workload(&app->bursts, w);
+        }
+    }
+    return 1;
+}
+
+static int load(const char *path, uint32_t copies) {
+    int ret = load_trace(path, copies);
+    if (ret != 0) return ret;
+    for (uint32_t c = 0; c < copies; c++) {
+        lg_app_t *app = new_app(path, -1);
+        if (!app) return -1;
+        if (read_queue_from_file(&app->bursts, path) <= 0) {
+            fprintf(stderr, "Failed to read burst file %s\n", path);
+            return -1;
+        }
+    }
+    return 1;
+}
+
+static void finish(lg_app_t *app, int ok) {
+    if (ok) {
+        if (!quiet) app_print_report(&app->state, app->name, app->pid);
+    } else {
+        fprintf(stderr, "Application %s (PID %d) failed\n", app->name, app->pid);
+        failed++;
+    }
+    if (app->fd >= 0) close(app->fd);   // também o tira do epoll
+    app->fd = -1;
+    free_burst_queue(&app->bursts);
+    finished++;
+}
+
+static int watch(lg_app_t *app, int op, uint32_t events) {
+    struct epoll_event ev = {.events = events, .data.u32 = (uint32_t) (app - apps)};
+    return epoll_ctl(epoll_fd, op, app->fd, &ev);
+}
+
+// Write what is left of the current request; EPOLLOUT is only watched while it does not fit
+static void flush_out(lg_app_t *app) {
+    while (app->out_sent < sizeof(msg_t)) {
+        ssize_t n = write(app->fd, (const char *) &app->out + app->out_sent, sizeof(msg_t) - app->out_sent);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN && watch(app, EPOLL_CTL_MOD, EPOLLIN | EPOLLOUT) == 0) return;
+            perror("write");
+            finish(app, 0);
+            return;
+        }
+        app->out_sent += (size_t) n;
+    }
+}
+
+static void send_next(lg_app_t *app) {
+    if (!app_next_request(&app->state, &app->bursts, app->pid, &app->out)) {
+        finish(app, 1);
+        return;
+    }
+    app->out_sent = 0;
+    flush_out(app);
+}
+
+static void on_readable(lg_app_t *app) {
+    for (;;) {
+        ssize_t n = read(app->fd, app->in + app->in_len, sizeof(app->in) - app->in_len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == EAGAIN) return;
+        if (n <= 0) {
+            if (n < 0) perror("read");
+            else fprintf(stderr, "Scheduler closed the connection of %s\n", app->name);
+            finish(app, 0);
+            return;
+        }
+        app->in_len += (size_t) n;
+        size_t off = 0;
+        while (app->in_len - off >= sizeof(msg_t)) {
+            msg_t msg;
+            memcpy(&msg, app->in + off, sizeof(msg_t));
+            off += sizeof(msg_t);
+            int done = app_handle_reply(&app->state, &msg);
+            if (done < 0) {
+                finish(app, 0);
+                return;
+            }
+            if (done) {
+                send_next(app);
+                if (app->fd < 0) return;    // acabou
+            }
+        }
+        memmove(app->in, app->in + off, app->in_len - off);
+        app->in_len -= off;
+    }
+}
+
+// Connect an application: 1 if it started, 0 to retry later (backlog full), -1 if it failed
+static int start(lg_app_t *app) {
+    app->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (app->fd < 0) {
+        perror("socket");
+        finish(app, 0);
+        return -1;
+    }
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, SOCKET_PATH, sizeof(addr.sun_path) - 1);
+    if (connect(app->fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+        if (errno == EAGAIN) {
+            close(app->fd);
+            app->fd = -1;
+            return 0;
+        }
+        perror("connect");
+        finish(app, 0);
+        return -1;
+    }
+    if (watch(app, EPOLL_CTL_ADD, EPOLLIN) < 0) {
+        perror("epoll_ctl");
+        finish(app, 0);
+        return -1;
+    }
+    send_next(app);
+    return 1;
+}
+
+static void usage(const char *prog) {
+    printf("Usage: %s [--rate R | --poisson R] [--copies N] [--seed S] [--quiet] <burst-file | trace.bwlt>...\n", prog);
+    printf("  --rate R      start R applications per second, evenly spaced (default: all at once)\n");
+    printf("  --poisson R   start R applications per second on average, with exponential gaps\n");
+    printf("  --copies N    run N applications of each file (default 1)\n");
+    printf("  --seed S      seed of the Poisson arrivals (default 1)\n");
+    printf("  --quiet       only print the summary, not the line of each application\n");
+}
+
+int main(int argc, char *argv[]) {
+    double rate = 0;            // applications per second, 0 for all at once
+    int poisson = 0;            // 1 for exponential gaps between arrivals
+    uint32_t copies = 1;
+    uint64_t seed = 1;
+    static const struct option long_options[] = {
+        {"rate", required_argument, NULL, 'r'},
+        {"poisson", required_argument, NULL, 'p'},
+        {"copies", required_argument, NULL, 'c'},
+        {"seed", required_argument, NULL, 's'},
+        {"quiet", no_argument, NULL, 'q'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "r:p:c:s:q", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'r':
+                rate = atof(optarg);
+                poisson = 0;
+                break;
+            case 'p':
+                rate = atof(optarg);
+                poisson = 1;
+                break;
+            case 'c':
+                copies = (uint32_t) strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'q':
+                quiet = 1;
+                break;
+            default:
+                usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (optind >= argc || copies == 0 || rate < 0) {
+        usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    for (int i = optind; i < argc; i++) {
+        if (load(argv[i], copies) < 0) return EXIT_FAILURE;
+    }
+
+    // Arrival times, fixed before the run (open loop)
+    double t = 0;
+    for (uint32_t i = 0; i < napps; i++) {
+        apps[i].arrival_s = t;
+        if (rate > 0) {
+            t += poisson ? -log(1.0 - rng_uniform01(&seed)) / rate : 1.0 / rate;
+        }
+    }
+
+    raise_fd_limit((uint64_t) napps + 64);   // um socket por aplicação
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        perror("epoll_create1");
+        return EXIT_FAILURE;
+    }
+
+    double t0 = now_s();
+    uint32_t next = 0;          // Next application to arrive
+    uint64_t retries = 0;       // Connections retried because the backlog was full
+    struct epoll_event events[MAX_EVENTS];
+    while (finished < napps) {
+        double elapsed = now_s() - t0;
+        int timeout = -1;
+        while (next < napps && apps[next].arrival_s <= elapsed) {
+            int ret = start(&apps[next]);
+            if (ret == 0) {
+                retries++;
+                timeout = RETRY_MS;
+                break;
+            }
+            next++;
+        }
+        if (next < napps && timeout < 0) {
+            timeout = (int) ceil((apps[next].arrival_s - elapsed) * 1000.0);
+        }
+        if (finished == napps) break;
+        int n = epoll_wait(epoll_fd, events, MAX_EVENTS, timeout);
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            return EXIT_FAILURE;
+        }
+        for (int i = 0; i < n; i++) {
+            lg_app_t *app = &apps[events[i].data.u32];
+            if (app->fd < 0) continue;
+            if (events[i].events & EPOLLOUT) {
+                flush_out(app);
+                if (app->fd >= 0 && app->out_sent == sizeof(msg_t)) watch(app, EPOLL_CTL_MOD, EPOLLIN);
+            }
+            if (app->fd >= 0 && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) on_readable(app);
+        }
+    }
+    double wall = now_s() - t0;
+
+    printf("Ran %u applications (%u failed) in %.3f s of wall time, %llu connections retried\n",
+           napps, failed, wall, (unsigned long long) retries);
+    for (uint32_t i = 0; i < napps; i++) free(apps[i].name);
+    free(apps);
+    for (uint32_t i = 0; i < ntraces; i++) munmap(traces[i].data, traces[i].size);
+    free(traces);
+    close(epoll_fd);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -18,7 +18,11 @@ static const char PROCESS_REQUEST_STRINGS[][10] = {
     "RUN",
     "BLOCK",
     "ACK",
-    "DONE"
+    "DONE",
+    "SHM",
+    "SCRIPT",
+    "REPORT",
+    "HELLO"
 };
 
 // Define the types of requests a process can make to the scheduler
@@ -27,8 +31,32 @@ typedef enum  {
     PROCESS_REQUEST_BLOCK,
     PROCESS_REQUEST_ACK,
     PROCESS_REQUEST_DONE,
+    PROCESS_REQUEST_SHM,            // Handshake: switch to the shared-memory channel passed with SCM_RIGHTS
+    PROCESS_REQUEST_SCRIPT,         // Run a whole burst script, time_ms bytes of script follow the message
+    PROCESS_REQUEST_REPORT,         // Final report of a script, time_ms bytes of script_report_t follow
+    PROCESS_REQUEST_HELLO,          // First message only: ask for protocol version time_ms (see msg_hdr_t)
 } process_request_t;
 
+// Protocol versions. A connection speaks v1 (bare msg_t) unless its first message is
+// a v1 HELLO asking for a newer version; the ACK to the HELLO (a v1 msg_t) carries the
+// version granted in time_ms, and from then on both sides only send v2 frames.
+#define PROTOCOL_V1 1
+#define PROTOCOL_V2 2
+
+// A v2 frame is a msg_hdr_t followed by length bytes of payload. RUN, BLOCK, ACK and
+// DONE carry their time (uint32_t) as payload, SCRIPT and REPORT their usual payload.
+// Replies carry the seq of the request they answer. With MSG_FLAG_NO_ACK a request
+// gets no ACK, only its DONE.
+#define MSG_FLAG_NO_ACK 1u
+
+typedef struct {
+    uint8_t version;                // PROTOCOL_V2
+    uint8_t type;                   // process_request_t
+    uint16_t flags;                 // MSG_FLAG_*
+    uint32_t seq;                   // Sequence number chosen by the application
+    uint32_t length;                // Bytes of payload after the header
+} msg_hdr_t;
+
 // Define the structure for page information
 // Note: Not used until we get to memory management, but defined here for completeness
 typedef struct {
@@ -44,5 +72,32 @@ typedef struct {
     uint32_t time_ms;               // Time information
 } msg_t;
 
+// A burst script is one variable-length frame: a msg_t with PROCESS_REQUEST_SCRIPT
+// and the payload length in time_ms, then a script_header_t and count bursts. Each
+// burst is a script_burst_t followed by page_count page ids (uint32_t).
+// The scheduler answers with one ACK, one DONE per finished burst (unless
+// SCRIPT_FLAG_FINAL_REPORT is set) and finally a PROCESS_REQUEST_REPORT frame.
+#define SCRIPT_MAX_BYTES (1u << 20)         // Largest script payload accepted
+#define SCRIPT_FLAG_FINAL_REPORT 1u         // Only send the final report, no per-burst DONE
+
+typedef struct {
+    uint32_t count;                 // Number of bursts
+    uint32_t flags;                 // SCRIPT_FLAG_*
+} script_header_t;
+
+typedef struct {
+    uint32_t burst_time_ms;         // CPU time of the burst
+    uint32_t block_time_ms;         // Block time after the burst (0 for none)
+    int32_t nice;                   // Nice value (priority)
+    uint32_t page_count;            // Number of page ids that follow
+} script_burst_t;
+
+typedef struct {
+    uint32_t start_time_ms;         // Time the script was accepted
+    uint32_t end_time_ms;           // Time the last burst finished
+    uint32_t cpu_time_ms;           // CPU time of all bursts
+    uint32_t block_time_ms;         // Block time of all bursts
+    uint32_t bursts;                // Number of bursts run
+} script_report_t;
 
 #endif //COMMON_H
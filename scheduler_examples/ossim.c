@@ -1,46 +1,77 @@
+#include <limits.h>
+#include <signal.h>
 #include <stdio.h>
 #include <sys/socket.h>
+#include <sys/timerfd.h>
 #include <sys/un.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <string.h>
+#include <getopt.h>
 
 #include "debug.h"
 
-#define MAX_CLIENTS 128
+#define DEFAULT_BACKLOG 4096   // pending connections in listen() (--backlog), capped by net.core.somaxconn
+#define MAX_CPUS 1024   // maximum number of simulated cores (--cpus)
+#define SELF_FDS 64     // file descriptors of the simulator itself, besides the client sockets
+// maximum of --max-procs: each application needs a pcb and a connection slot
+#define MAX_PROCS ((PCB_POOL_MAX_CAPACITY < CONN_MAX) ? PCB_POOL_MAX_CAPACITY : CONN_MAX)
 
 #include <stdlib.h>
 #include <sys/errno.h>
 
-#include "fifo.h"
-#include "SJF.h"
-#include "RR.h"
-#include "MLFQ.h"
+#include "sched_policy.h"
 
 #include "msg.h"
 #include "queue.h"
+#include "timer_wheel.h"
+#include "pcb_pool.h"
+#include "io_thread.h"
+#include "shm_channel.h"
+#include "script.h"
+#include "tick_clock.h"
+#include "util.h"
 
-mlfq_t *mq = NULL;   // estrutura de mensagens entre scheduler e aplicações (msg_t)
 static uint32_t PID = 0;   // contador estático para gerar PIDs únicos
 
+static tick_clock_t tick_clock;     // relógio real que marca o ritmo dos ticks
+static volatile sig_atomic_t stop_requested = 0;   // SIGINT/SIGTERM: sai do ciclo principal e imprime as estatísticas
+
+// A simulated CPU core: its own instance of the scheduling policy (its run queue) and the task it runs
+typedef struct {
+    scheduler_t sched;      // política de escalonamento e as tarefas prontas deste core
+    pcb_t *running;         // tarefa em execução no core (NULL se livre)
+    uint32_t nready;        // número de tarefas prontas na política deste core
+} core_t;
+
+static core_t *cores;           // os cores simulados
+static uint32_t ncpus = 1;      // número de cores (--cpus)
+static uint32_t next_core = 0;  // core que recebe a próxima chegada (round-robin)
+
+static pcb_handle_t *conn_pcb;  // pcb de cada ligação, indexado por conn_index()
+static shm_endpoint_t **conn_shm;    // canal de memória partilhada de cada ligação (NULL: usa o socket)
+static uint32_t shm_clients = 0;    // número de ligações com canal de memória partilhada
+static script_t **pcb_script;       // script em execução de cada pcb, indexado pelo slot do pcb
+
 /**
  * @brief Set up the server socket for the scheduler.
  *
  * This function creates a UNIX domain socket, binds it to a specified path,
- * and sets it to listen for incoming connections. It also sets the socket to
- * non-blocking mode.
+ * and sets it to listen for incoming connections. The socket is created in
+ * non-blocking mode (and close-on-exec).
  *
  * @param socket_path The path where the socket will be created
+ * @param backlog Maximum number of connections waiting to be accepted
  * @return int Returns the server file descriptor on success, or -1 on failure
  */
-int setup_server_socket(const char *socket_path) {
+int setup_server_socket(const char *socket_path, int backlog) {
     int server_fd;   // descritor do socket do servidor
     struct sockaddr_un addr;   // estrutura de endereço para sockets UNIX
 
     unlink(socket_path);   // remove ficheiro de socket antigo (ignora erros)
 
-    // Create UNIX socket
-    if ((server_fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+    // Create UNIX socket, non-blocking for the I/O thread
+    if ((server_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0) {
         perror("socket");
         return -1; // falha
     }
@@ -57,293 +88,825 @@ int setup_server_socket(const char *socket_path) {
     }
 
     // Listen
-    if (listen(server_fd, MAX_CLIENTS) < 0) {
+    if (listen(server_fd, backlog) < 0) {
         perror("listen");
         close(server_fd);   // fecha....
         return -1;  // falha
     }
-    // Set the socket to non-blocking mode
-    int flags = fcntl(server_fd, F_GETFL, 0); // obtém flags atuais do descritor
-    if (flags != -1) {
-        if (fcntl(server_fd, F_SETFL, flags | O_NONBLOCK) == -1) {
-            perror("fcntl: set non-blocking");
+    return server_fd;   // retorna o descritor do servidor em caso de sucesso
+}
+
+/**
+ * @brief Send an ACK or DONE message to the application of a pcb.
+ *
+ * @param pcb The pcb of the application
+ * @param request The type of message (PROCESS_REQUEST_ACK or PROCESS_REQUEST_DONE)
+ * @param current_time_ms The current time in milliseconds, sent to the application
+ */
+static void send_reply(const pcb_t *pcb, process_request_t request, uint32_t current_time_ms) {
+    if (pcb->conn == CONN_ID_NONE) return;   // a aplicação já saiu
+    msg_t msg = {
+        .pid = pcb->pid,   // pid do processo a quem responde
+        .request = request,
+        .time_ms = current_time_ms  //  timestamp atual
+    };
+    shm_endpoint_t *shm = conn_shm[conn_index(pcb->conn)];
+    if (shm) {
+        if (!shm_channel_send_reply(shm, &msg)) {   // sem syscall, exceto se a aplicação dorme
+            fprintf(stderr, "Shared-memory reply ring of process %d is full\n", pcb->pid);
         }
+    } else {
+        io_send(pcb->conn, &msg);   // o I/O thread escreve no socket
     }
-    return server_fd;   // retorna o descritor do servidor em caso de sucesso
+    DBG("Send %s message to process %d with time %d\n", PROCESS_REQUEST_STRINGS[request], pcb->pid, current_time_ms);
 }
 
 /**
- * @brief Check for new client connections and add them to the queue.
+ * @brief Move a pcb back to the command queue, to wait for the next request of its application.
  *
- * This function accepts new client connections on the server socket,
- * sets the client sockets to non-blocking mode, and enqueues them
- * into the provided queue.
+ * If the application went away while the pcb was ready, running or blocked, the pcb
+ * is freed instead.
  *
- * @param command_queue The queue to which new pcb will be added
- * @param server_fd The server socket file descriptor
+ * @param pcb The pcb
+ * @param command_queue The queue of pcbs waiting for instructions
+ * @param current_time_ms The current time in milliseconds
  */
-void check_new_commands(queue_t *command_queue, queue_t *blocked_queue, queue_t *ready_queue, int server_fd, uint32_t current_time_ms) {
-    // Accept new client connections
-    int client_fd;
-    do {
-        client_fd = accept(server_fd, NULL, NULL);  // aceita cliente
-        if (client_fd < 0) {
-            if (errno == EMFILE || errno == ENFILE) {
-                perror("accept: too many fds");
-                break;  // sai do loop
-            }
-            if (errno == EINTR)        continue;   // interrompido por sinal - tente novamente
-            if (errno == ECONNABORTED) continue;   // handshake abortado -> next
-            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
-                perror("accept");
-            }
-            // No more clients to accept right now
-            break;
-        }
-        int flags = fcntl(client_fd, F_GETFL, 0); // Get current flags
-        if (flags != -1) {
-            if (fcntl(client_fd, F_SETFL, flags | O_NONBLOCK) == -1) {
-                perror("fcntl: set non-blocking");
-            }
-        }
-        // Set close-on-exec flag
-        int fdflags = fcntl(client_fd, F_GETFD, 0);  // obtem flags do descritor
-        if (fdflags != -1) {
-            fcntl(client_fd, F_SETFD, fdflags | FD_CLOEXEC);
+static void return_to_command(pcb_t *pcb, queue_t *command_queue, uint32_t current_time_ms) {
+    if (pcb->conn == CONN_ID_NONE) {
+        free_pcb(pcb);  // libera o pcb (a ligação já fechou)
+        return;
+    }
+    pcb->status = TASK_COMMAND;  // muda estado para command (aguarda nova instrução)
+    pcb->last_update_time_ms = current_time_ms;   // atualiza timestamp de última modificação
+    enqueue_pcb(command_queue, pcb);
+}
+
+/**
+ * @brief Forget a connection and free its slot in the I/O thread.
+ *
+ * The pcb of the connection is freed at once if it waits in the command queue,
+ * otherwise when it returns there (see return_to_command).
+ *
+ * @param conn The connection
+ * @param pcb The pcb of the connection, or NULL
+ * @param command_queue The queue of pcbs waiting for instructions
+ */
+static void drop_connection(conn_id_t conn, pcb_t *pcb, queue_t *command_queue) {
+    uint32_t index = conn_index(conn);
+    conn_pcb[index] = PCB_HANDLE_NONE;
+    if (conn_shm[index]) {
+        shm_channel_release(conn_shm[index]);
+        conn_shm[index] = NULL;
+        shm_clients--;
+    }
+    io_release(conn);
+    if (!pcb) return;
+    pcb->conn = CONN_ID_NONE;
+    if (pcb->status == TASK_COMMAND) {
+        remove_pcb(command_queue, pcb);
+        free_pcb(pcb);  // libera o pcb (fechou a conexao)
+    }
+}
+
+/**
+ * @brief Hand a pcb that needs the CPU to the run queue of one of the cores (round-robin).
+ *
+ * If the policy of the core cannot take the pcb (it ran out of memory), the connection
+ * is closed and the pcb freed, so the application does not wait for a reply forever.
+ *
+ * @param pcb The pcb
+ * @param time_ms The CPU time requested
+ * @param command_queue The queue of pcbs waiting for instructions
+ * @param current_time_ms The current time in milliseconds
+ * @return 1 if the pcb was queued, 0 if it was freed
+ */
+static int submit_run(pcb_t *pcb, uint32_t time_ms, queue_t *command_queue, uint32_t current_time_ms) {
+    pcb->time_ms = time_ms; // define o tempo de CPU pedido
+    pcb->ellapsed_time_ms = 0; // zera tempo já executado
+    pcb->status = TASK_RUNNING;  // pronto a correr
+    core_t *core = &cores[next_core];   // as chegadas são distribuídas pelos cores
+    next_core = (next_core + 1) % ncpus;
+    if (!core->sched.policy->enqueue(core->sched.state, pcb, current_time_ms)) {  // entrega o pcb à política do core
+        fprintf(stderr, "%s: cannot queue process %d, closing its connection\n", core->sched.policy->name, pcb->pid);
+        uint32_t index = pcb_handle(pcb) & PCB_INDEX_MASK;
+        if (pcb_script[index]) {
+            script_free(pcb_script[index]);
+            pcb_script[index] = NULL;
         }
-        DBG("[Scheduler] New client connected: fd=%d\n", client_fd);  // debug
-        // New PCBs do not have a time yet, will be set when we receive a RUN message
-        pcb_t *pcb = new_pcb(++PID, client_fd, 0);  // cria um novo PCB com PID incremental e time 0
-        enqueue_pcb(command_queue, pcb);
-    } while (client_fd > 0);  // continua enquanto aceitar clientes
-
-    // Check queue for new commands in the command queue
-    queue_elem_t * elem = command_queue->head;   // itera a partir da cabeça da command_queue
-    while (elem != NULL) {
-        pcb_t *current_pcb = elem->pcb;   // pcb atual a verificar
+        drop_connection(pcb->conn, pcb, command_queue);   // o pcb não está em nenhuma fila
+        free_pcb(pcb);
+        return 0;
+    }
+    core->nready++;
+    return 1;
+}
+
+/**
+ * @brief Move a pcb to the blocked queue.
+ *
+ * @param pcb The pcb
+ * @param time_ms The block time requested
+ * @param blocked_queue The timing wheel for blocked pcbs
+ */
+static void submit_block(pcb_t *pcb, uint32_t time_ms, timer_wheel_t *blocked_queue) {
+    pcb->time_ms = time_ms;  // define tempo de bloqueio
+    pcb->status = TASK_BLOCKED;  // marca como bloqueado
+    // The block is counted from the last tick processed by the wheel
+    timer_wheel_add(blocked_queue, pcb, timer_wheel_time_ms(blocked_queue) + time_ms);
+}
+
+/**
+ * @brief Handle a request from a pcb waiting in the command queue.
+ *
+ * RUN requests hand the pcb to the run queue of one of the cores (round-robin) and
+ * BLOCK requests move it to the blocked queue, after which an ACK is sent back.
+ *
+ * @param current_pcb The pcb that sent the request
+ * @param msg The request
+ * @param command_queue The queue the pcb is waiting in
+ * @param blocked_queue The timing wheel for pcbs that requested a BLOCK
+ * @param current_time_ms The current time in milliseconds
+ */
+static void handle_command(pcb_t *current_pcb, const msg_t *msg, queue_t *command_queue, timer_wheel_t *blocked_queue, uint32_t current_time_ms) {
+    // We have received a message
+    if (msg->request == PROCESS_REQUEST_RUN) {
+        current_pcb->pid = msg->pid; // Set the pid from the message
+        remove_pcb(command_queue, current_pcb);
+        if (!submit_run(current_pcb, msg->time_ms, command_queue, current_time_ms)) return;
+        DBG("Process %d requested RUN for %d ms\n", current_pcb->pid, current_pcb->time_ms);  // debug
+    } else if (msg->request == PROCESS_REQUEST_BLOCK) {
+        current_pcb->pid = msg->pid; // Set the pid from the message
+        remove_pcb(command_queue, current_pcb);
+        submit_block(current_pcb, msg->time_ms, blocked_queue);
+        DBG("Process %d requested BLOCK for %d ms\n", current_pcb->pid, current_pcb->time_ms);
+    } else {
+        printf("Unexpected message received from client\n");
+        return;  // ignora e continua
+    }
+
+    // Send ack message
+    send_reply(current_pcb, PROCESS_REQUEST_ACK, current_time_ms);
+}
+
+/**
+ * @brief Switch the connection of a pcb to the shared-memory channel it passed.
+ *
+ * The ACK of the handshake still goes over the socket. If the channel is not valid
+ * the connection is closed.
+ *
+ * @param pcb The pcb that sent the PROCESS_REQUEST_SHM handshake
+ * @param fd The memfd holding the channel (closed by this function)
+ * @param command_queue The queue of pcbs waiting for instructions
+ * @param current_time_ms The current time in milliseconds
+ */
+static void attach_shm(pcb_t *pcb, int fd, queue_t *command_queue, uint32_t current_time_ms) {
+    uint32_t index = conn_index(pcb->conn);
+    shm_endpoint_t *shm = (fd >= 0 && conn_shm[index] == NULL) ? shm_channel_attach(fd) : NULL;
+    if (fd >= 0) close(fd);     // the mapping stays valid
+    if (!shm) {
+        drop_connection(pcb->conn, pcb, command_queue);
+        return;
+    }
+    send_reply(pcb, PROCESS_REQUEST_ACK, current_time_ms);
+    conn_shm[index] = shm;
+    shm_clients++;
+    DBG("Process %d switched to shared memory\n", pcb->pid);
+}
+
+/**
+ * @brief Handle the requests that applications placed in their shared-memory channels.
+ *
+ * Only pcbs in the command queue are expected to send requests, so only their
+ * channels are polled.
+ *
+ * @param command_queue The queue of pcbs waiting for instructions
+ * @param blocked_queue The timing wheel for pcbs that requested a BLOCK
+ * @param current_time_ms The current time in milliseconds
+ */
+static void poll_shm_channels(queue_t *command_queue, timer_wheel_t *blocked_queue, uint32_t current_time_ms) {
+    pcb_t *pcb = queue_head(command_queue);
+    while (pcb != NULL) {
+        pcb_t *next = queue_next(pcb);  // handle_command remove o pcb da fila
+        shm_endpoint_t *shm = conn_shm[conn_index(pcb->conn)];
         msg_t msg;
-        int n = read(current_pcb->sockfd, &msg, sizeof(msg_t)); // tenta ler mensagem
-        if (n <= 0) {
-            if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                // No data available right now, move to next
-                elem = elem->next;  // nao ha dados, next
-            } else {
-                if (n < 0) {
-                    perror("read");
-                } else {
-                    DBG("Connection closed by remote host\n");  // n = 0, conexao fechada pelo cliente
-                }
-                // Remove from queue
-                queue_elem_t *tmp = elem;   // guarda elemento atual para remoçao
-                elem = elem->next;  // avança antes de libertar
-                free(current_pcb);  // libera o pcb (fechou a conexao)
-                free(tmp);  //libera o elemento da fila
-            }
-            continue;
+        if (shm && shm_channel_poll_request(shm, &msg)) {
+            handle_command(pcb, &msg, command_queue, blocked_queue, current_time_ms);
         }
-        // We have received a message
-        if (msg.request == PROCESS_REQUEST_RUN) {
-            current_pcb->pid = msg.pid; // Set the pid from the message
-            current_pcb->time_ms = msg.time_ms; // define o tempo de CPU pedido
-            current_pcb->ellapsed_time_ms = 0; // zera tempo já executado
-            current_pcb->status = TASK_RUNNING;  // pronto a correr
-            enqueue_pcb(ready_queue, current_pcb);  // move pcb para ready_queue
-            DBG("Process %d requested RUN for %d ms\n", current_pcb->pid, current_pcb->time_ms);  // debug
-        } else if (msg.request == PROCESS_REQUEST_BLOCK) {
-            current_pcb->pid = msg.pid; // Set the pid from the message
-            current_pcb->time_ms = msg.time_ms;  // define tempo de bloqueio
-            current_pcb->status = TASK_BLOCKED;  // marca como bloqueado
-            enqueue_pcb(blocked_queue, current_pcb);  // alinha block_queue
-            DBG("Process %d requested BLOCK for %d ms\n", current_pcb->pid);
-        } else {
-            printf("Unexpected message received from client\n");
-            continue;  // ignora e continua
+        pcb = next;
+    }
+}
+
+/**
+ * @brief Start the next burst of a script, or finish the script after the last one.
+ *
+ * Bursts without CPU or block time finish at once. When the script is over, the
+ * final report is sent and the pcb goes back to the command queue.
+ *
+ * @param pcb The pcb running the script
+ * @param script Its script
+ * @param command_queue The queue of pcbs waiting for instructions
+ * @param blocked_queue The timing wheel for blocked pcbs
+ * @param current_time_ms The current time in milliseconds
+ */
+static void script_start_burst(pcb_t *pcb, script_t *script, queue_t *command_queue, timer_wheel_t *blocked_queue, uint32_t current_time_ms) {
+    while (script->next < script->count) {
+        const script_step_t *step = &script->steps[script->next];
+        if (step->burst_time_ms > 0) {
+            submit_run(pcb, step->burst_time_ms, command_queue, current_time_ms);
+            return;
+        }
+        if (step->block_time_ms > 0) {
+            script->blocked = 1;
+            submit_block(pcb, step->block_time_ms, blocked_queue);
+            return;
         }
-        // Remove from command queue
-        remove_queue_elem(command_queue, elem);
-        queue_elem_t *tmp = elem;  // guarda para liberar
-        elem = elem->next;  // avança antes de free
-        free(tmp);  // libera o elemento da fila (o PCB foi movido)
-
-        // Send ack message
-        msg_t ack_msg = {
-            .pid = current_pcb->pid,   // pid do processo a quem responde
-            .request = PROCESS_REQUEST_ACK,  // tipo ACK
-            .time_ms = current_time_ms  //  timestamp atual
-        };
-        if (write(current_pcb->sockfd, &ack_msg, sizeof(msg_t)) != sizeof(msg_t)) {
-            perror("write");
+        script->next++;     // burst vazio
+        script->report.bursts++;
+        if (!(script->flags & SCRIPT_FLAG_FINAL_REPORT)) send_reply(pcb, PROCESS_REQUEST_DONE, current_time_ms);
+    }
+
+    // Script terminado: envia o relatório final
+    script->report.end_time_ms = current_time_ms;
+    script_report_t *report = malloc(sizeof(script_report_t));
+    if (report && pcb->conn != CONN_ID_NONE) {
+        *report = script->report;
+        msg_t msg = {.pid = pcb->pid, .request = PROCESS_REQUEST_REPORT, .time_ms = sizeof(script_report_t)};
+        io_send_frame(pcb->conn, &msg, report);
+        DBG("Process %d finished its script of %u bursts\n", pcb->pid, script->count);
+    } else {
+        free(report);
+    }
+    pcb_script[pcb_handle(pcb) & PCB_INDEX_MASK] = NULL;
+    script_free(script);
+    return_to_command(pcb, command_queue, current_time_ms);
+}
+
+/**
+ * @brief A pcb finished its CPU burst or its block.
+ *
+ * Without a script a DONE is sent and the pcb goes back to the command queue.
+ * With a script, the pcb blocks after its CPU burst if the burst has a block time,
+ * and otherwise moves on to the next burst, after a DONE (progress) message.
+ *
+ * @param pcb The pcb
+ * @param command_queue The queue of pcbs waiting for instructions
+ * @param blocked_queue The timing wheel for blocked pcbs
+ * @param current_time_ms The current time in milliseconds
+ */
+static void burst_finished(pcb_t *pcb, queue_t *command_queue, timer_wheel_t *blocked_queue, uint32_t current_time_ms) {
+    script_t *script = pcb_script[pcb_handle(pcb) & PCB_INDEX_MASK];
+    if (!script) {
+        send_reply(pcb, PROCESS_REQUEST_DONE, current_time_ms);   // sinaliza fim do burst
+        return_to_command(pcb, command_queue, current_time_ms);     // aguarda nova instrução
+        return;
+    }
+    if (pcb->conn == CONN_ID_NONE) {   // a aplicação saiu a meio do script
+        script->next = script->count;
+        script_start_burst(pcb, script, command_queue, blocked_queue, current_time_ms);
+        return;
+    }
+    const script_step_t *step = &script->steps[script->next];
+    if (!script->blocked) {
+        script->report.cpu_time_ms += step->burst_time_ms;
+        if (step->block_time_ms > 0) {
+            script->blocked = 1;
+            submit_block(pcb, step->block_time_ms, blocked_queue);
+            return;
         }
-        DBG("Send ACK message to process %d with time %d\n", current_pcb->pid, current_time_ms);
+    } else {
+        script->report.block_time_ms += step->block_time_ms;
     }
+    script->blocked = 0;
+    script->next++;
+    script->report.bursts++;
+    if (!(script->flags & SCRIPT_FLAG_FINAL_REPORT)) send_reply(pcb, PROCESS_REQUEST_DONE, current_time_ms);
+    script_start_burst(pcb, script, command_queue, blocked_queue, current_time_ms);
+}
 
+/**
+ * @brief Start running the burst script uploaded by an application.
+ *
+ * @param pcb The pcb that sent the PROCESS_REQUEST_SCRIPT frame
+ * @param msg The header of the frame
+ * @param payload The payload of the frame (freed by this function)
+ * @param command_queue The queue of pcbs waiting for instructions
+ * @param blocked_queue The timing wheel for blocked pcbs
+ * @param current_time_ms The current time in milliseconds
+ */
+static void start_script(pcb_t *pcb, const msg_t *msg, void *payload, queue_t *command_queue, timer_wheel_t *blocked_queue, uint32_t current_time_ms) {
+    // Scripts use the socket, the shared-memory rings only carry msg_t
+    script_t *script = conn_shm[conn_index(pcb->conn)] ? NULL : script_parse(payload, msg->time_ms);
+    free(payload);
+    if (!script) {
+        fprintf(stderr, "Invalid script from process %d\n", msg->pid);
+        drop_connection(pcb->conn, pcb, command_queue);
+        return;
+    }
+    pcb->pid = msg->pid; // Set the pid from the message
+    remove_pcb(command_queue, pcb);
+    pcb_script[pcb_handle(pcb) & PCB_INDEX_MASK] = script;
+    script->report.start_time_ms = current_time_ms;
+    send_reply(pcb, PROCESS_REQUEST_ACK, current_time_ms);
+    DBG("Process %d uploaded a script of %u bursts\n", pcb->pid, script->count);
+    script_start_burst(pcb, script, command_queue, blocked_queue, current_time_ms);
+}
+
+/**
+ * @brief Handle the connections, requests and hang-ups posted by the I/O thread.
+ *
+ * The sockets are owned by the I/O thread, so this never blocks: it only drains the
+ * events that were already parsed. Clients are only expected to talk while their pcb
+ * is in the command queue. A client that goes away while its pcb is ready, running
+ * or blocked keeps its pcb until the pcb returns to the command queue, where it is
+ * freed (see return_to_command).
+ *
+ * @param command_queue The queue to which new pcb will be added
+ * @param blocked_queue The timing wheel for pcbs that requested a BLOCK
+ * @param current_time_ms The current time in milliseconds
+ */
+void check_new_commands(queue_t *command_queue, timer_wheel_t *blocked_queue, uint32_t current_time_ms) {
+    io_msg_t ev;
+    while (io_next_event(&ev)) {
+        uint32_t index = conn_index(ev.conn);
+        pcb_t *pcb = pcb_get(conn_pcb[index]);
+        switch (ev.type) {
+            case IO_EVENT_CONNECT:
+                // New PCBs do not have a time yet, will be set when we receive a RUN message
+                pcb = new_pcb(++PID, ev.conn, 0);  // cria um novo PCB com PID incremental e time 0
+                if (!pcb) {
+                    fprintf(stderr, "new_pcb: too many applications\n");
+                    io_release(ev.conn);
+                    break;
+                }
+                conn_pcb[index] = pcb_handle(pcb);
+                enqueue_pcb(command_queue, pcb);
+                break;
+            case IO_EVENT_REQUEST:
+                if (pcb && pcb->status == TASK_COMMAND) {
+                    handle_command(pcb, &ev.msg, command_queue, blocked_queue, current_time_ms);
+                } else {
+                    printf("Unexpected message received from client\n");
+                }
+                break;
+            case IO_EVENT_SCRIPT:
+                if (pcb && pcb->status == TASK_COMMAND) {
+                    start_script(pcb, &ev.msg, ev.data, command_queue, blocked_queue, current_time_ms);
+                } else {
+                    free(ev.data);
+                    printf("Unexpected message received from client\n");
+                }
+                break;
+            case IO_EVENT_SHM:
+                if (pcb && pcb->status == TASK_COMMAND) {
+                    attach_shm(pcb, (int) ev.msg.time_ms, command_queue, current_time_ms);
+                } else if ((int) ev.msg.time_ms >= 0) {
+                    close((int) ev.msg.time_ms);
+                }
+                break;
+            default:    // IO_EVENT_CLOSE
+                DBG("Connection closed by remote host\n");
+                drop_connection(ev.conn, pcb, command_queue);
+                break;
+        }
+    }
+    if (shm_clients > 0) {
+        poll_shm_channels(command_queue, blocked_queue, current_time_ms);
+    }
+    io_flush();     // envia os ACKs deste lote
 }
 
 /**
- * @brief Check the blocked queue for messages from clients.
+ * @brief Wake up the blocked pcbs whose block time has ended.
  *
- * This function iterates through the blocked queue, checking each client
- * socket for incoming messages. If a RUN message is received, the corresponding
- * pcb is moved to the command queue and an ACK message is sent back to the client.
- * If a client disconnects or an error occurs, the client is removed from the blocked queue.
+ * This function advances the timing wheel of blocked pcbs to the current tick.
+ * Only the bucket(s) of the ticks that expire are visited. Each woken pcb gets
+ * a DONE message and is moved back to the command queue, to wait for the next
+ * request of its application, unless it is running a burst script.
  *
- * @param blocked_queue The queue containing PCBs in I/O wait stated (blocked) from CPU
+ * @param blocked_queue The timing wheel containing PCBs in I/O wait stated (blocked) from CPU
  * @param command_queue The queue where PCBs ready for new instructions will be moved
  * @param current_time_ms The current time in milliseconds
  */
-void check_blocked_queue(queue_t * blocked_queue, queue_t * command_queue, uint32_t current_time_ms) {
-    // Check all elements of the blocked queue for new messages
-    queue_elem_t * elem = blocked_queue->head;  // começa na cabeça da blocked_queue
-    while (elem != NULL) {
-        pcb_t *pcb = elem->pcb;  // PCB atual a verificar
-
-        // Make sure the time is updated only once per cycle
-        if (pcb->last_update_time_ms < current_time_ms) {
-            if (pcb->time_ms > TICKS_MS) {
-                pcb->time_ms -= TICKS_MS;  // decrementa tempo de bloqueio em um tick
-            } else {
-                pcb->time_ms = 0;   // garante que não fica negativo
+void check_blocked_queue(timer_wheel_t * blocked_queue, queue_t * command_queue, uint32_t current_time_ms) {
+    queue_t woken = {.head = PCB_HANDLE_NONE, .tail = PCB_HANDLE_NONE};   // pcbs whose block ends in this tick
+    if (timer_wheel_advance(blocked_queue, current_time_ms, &woken) == 0) {
+        return;
+    }
+    pcb_t *pcb;
+    while ((pcb = dequeue_pcb(&woken)) != NULL) {
+        pcb->time_ms = 0;
+        DBG("Process %d finished BLOCK\n", pcb->pid);
+        // Send DONE message to the application, or go on with its script
+        burst_finished(pcb, command_queue, blocked_queue, current_time_ms);
+    }
+}
+
+/**
+ * @brief Charge run time to the task running on a core.
+ *
+ * The task on the core is charged elapsed_ms of run time. If it used all the time it
+ * requested, a DONE message is sent and the pcb goes back to the command queue, to
+ * wait for the next request of its application. If it was preempted, the policy of
+ * the core has already put it back in its ready tasks.
+ *
+ * @param core The core
+ * @param command_queue The queue where pcbs that finished their burst are moved
+ * @param current_time_ms The current time in milliseconds
+ * @param elapsed_ms Run time to charge to the task on the core
+ */
+static void tick_core(core_t *core, queue_t *command_queue, timer_wheel_t *blocked_queue, uint32_t current_time_ms, uint32_t elapsed_ms) {
+    pcb_t *task = core->running;
+    if (!task) return;
+    switch (core->sched.policy->tick(core->sched.state, task, current_time_ms, elapsed_ms)) {
+        case SCHED_TICK_DONE:
+            core->running = NULL;    // Marca que não há mais tarefa a correr
+            burst_finished(task, command_queue, blocked_queue, current_time_ms);
+            break;
+        case SCHED_TICK_PREEMPTED:
+            core->nready++;
+            core->running = NULL;    // a política já a recolocou nas tarefas prontas
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Give a task to every free core.
+ *
+ * A free core runs the next task of its own policy. If its run queue is empty it
+ * steals the next task of the core with the most ready tasks, so that no core idles
+ * while another one has tasks waiting.
+ *
+ * @param current_time_ms The current time in milliseconds
+ */
+static void dispatch_cores(uint32_t current_time_ms) {
+    for (uint32_t c = 0; c < ncpus; c++) {
+        core_t *core = &cores[c];
+        if (core->running) continue;
+        core_t *victim = core;
+        if (core->nready == 0) {   // nada para correr localmente: procura o core mais carregado
+            for (uint32_t v = 0; v < ncpus; v++) {
+                if (cores[v].nready > victim->nready) victim = &cores[v];
             }
+            if (victim->nready == 0) continue;
         }
-
-        if (pcb->time_ms == 0) {
-            // Send DONE message to the application
-            msg_t msg = {
-                .pid = pcb->pid,   // pid do processo que terminou o bloqueio
-                .request = PROCESS_REQUEST_DONE,   // sinaliza DONE
-                .time_ms = current_time_ms  // quando terminou
-            };
-            if (write(pcb->sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t)) {
-                perror("write");
+        core->running = victim->sched.policy->pick_next(victim->sched.state, current_time_ms);
+        if (core->running) {
+            victim->nready--;
+            if (victim != core) {
+                DBG("Core %u stole process %d from core %u\n", c, core->running->pid, (uint32_t) (victim - cores));
             }
-            DBG("Process %d finished BLOCK, sending DONE\n", pcb->pid);
-            pcb->status = TASK_COMMAND;  // muda estado para command (aguarda nova instrução)
-            pcb->last_update_time_ms = current_time_ms;   // atualiza timestamp de última modificação
-            enqueue_pcb(command_queue, pcb);   // move o PCB de volta para a fila de comandos
-
-            // Remove from blocked queue
-            remove_queue_elem(blocked_queue, elem);   // remove o elemento da blocked_queue
-            queue_elem_t *tmp = elem;   // guarda ponteiro para libertar
-            elem = elem->next;  // avança para o próximo, pois vamos liberar o atual
-            free(tmp);  // libera o elemento removido
-        } else {
-            elem = elem->next;  // If not done already, do it now
         }
     }
 }
 
-static const char *SCHEDULER_NAMES[] = {
-    "FIFO",
-    "SJF",
-    "RR",
-    "MLFQ",
-    NULL
-};  // array tipos scheduler
-
-typedef enum  {
-    NULL_SCHEDULER = -1,
-    SCHED_FIFO = 0,
-    SCHED_SJF,
-    SCHED_RR,
-    SCHED_MLFQ
-} scheduler_en;   // enumeraçao para tipos scheduler
-
-scheduler_en get_scheduler(const char *name) {   // Percorre o array de nomes de escalonadores até encontrar um igual ao argumento
-    for (int i = 0; SCHEDULER_NAMES[i] != NULL; i++) {
-        // Compara o nome passado com o nome do escalonador atual
-        if (strcmp(name, SCHEDULER_NAMES[i]) == 0) {
-            // Retorna o tipo de escalonador correspondente ao índice
-            return (scheduler_en)i;
+/**
+ * @brief Number of ticks until the next scheduling event in virtual-time mode.
+ *
+ * An event is a job finishing its CPU burst, a time slice expiring or a block
+ * ending, on any core. The result k means that the k-th tick from now is the first
+ * one in which something happens, so the k-1 ticks before it can be skipped.
+ *
+ * @return The number of ticks until the next event, or 0 if there is nothing pending
+ */
+static uint32_t ticks_to_next_event(const timer_wheel_t *blocked_queue, uint32_t current_time_ms) {
+    uint32_t ticks = 0;
+    uint32_t wake_time_ms;
+    if (timer_wheel_next_expiry(blocked_queue, &wake_time_ms)) {
+        ticks = (wake_time_ms > current_time_ms) ? (wake_time_ms - current_time_ms) / TICKS_MS + 1 : 1;
+    }
+    for (uint32_t c = 0; c < ncpus; c++) {
+        const core_t *core = &cores[c];
+        if (!core->running) continue;
+        const sched_policy_t *policy = core->sched.policy;
+        uint32_t left = policy->run_time_left ? policy->run_time_left(core->sched.state, core->running) : sched_time_left(core->running);
+        uint32_t t = (left + TICKS_MS - 1) / TICKS_MS;
+        if (t == 0) t = 1;
+        if (ticks == 0 || t < ticks) ticks = t;
+    }
+    return ticks;
+}
+
+/**
+ * @brief Check that there is nothing at all to simulate.
+ *
+ * No task runs on or waits for a core, none is blocked, and no application owes
+ * the simulator a request.
+ *
+ * @param command_queue The queue of pcbs waiting for instructions
+ * @param blocked_queue The timing wheel for blocked pcbs
+ * @return 1 if the simulator is idle, 0 otherwise
+ */
+static int simulator_idle(const queue_t *command_queue, const timer_wheel_t *blocked_queue) {
+    if (!queue_empty(command_queue) || blocked_queue->count > 0) return 0;
+    for (uint32_t c = 0; c < ncpus; c++) {
+        if (cores[c].running || cores[c].nready > 0) return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Sleep until the next scheduling event or the next message (tickless mode).
+ *
+ * The timer is armed for the real time of the tick of the next event (see
+ * ticks_to_next_event) and the I/O thread wakes us up earlier when an application
+ * sends something. The tasks running on the cores are then charged in one call to
+ * tick() for the ticks that went by, never past the tick of the next event.
+ *
+ * @param timer_fd A CLOCK_MONOTONIC timerfd
+ * @param command_queue The queue of pcbs waiting for instructions
+ * @param blocked_queue The timing wheel for blocked pcbs
+ * @param current_time_ms The time of the next tick to process
+ * @return The time of the tick to process after the wait
+ */
+static uint32_t tickless_wait(int timer_fd, queue_t *command_queue, timer_wheel_t *blocked_queue, uint32_t current_time_ms) {
+    uint32_t ticks = ticks_to_next_event(blocked_queue, current_time_ms);
+    // Requests over shared memory are polled, they cannot wake us up
+    if (shm_clients > 0 && !queue_empty(command_queue)) ticks = 1;
+
+    struct itimerspec its = {0};    // sem eventos: desarma o timer e espera só por mensagens
+    if (ticks > 0) {
+        tick_clock_deadline(&tick_clock, current_time_ms + (ticks - 1) * TICKS_MS, &its.it_value);
+    }
+    if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &its, NULL) < 0) perror("timerfd_settime");
+    if (ticks == 0 || tick_clock_now_ms(&tick_clock) < current_time_ms + (ticks - 1) * TICKS_MS) {
+        io_wait(timer_fd);
+    }
+
+    uint32_t now_ms = tick_clock_now_ms(&tick_clock) / TICKS_MS * TICKS_MS;
+    if (now_ms <= current_time_ms) return current_time_ms;
+    uint32_t skip = (now_ms - current_time_ms) / TICKS_MS;
+    if (ticks > 0 && skip > ticks - 1) skip = ticks - 1;    // o tick do evento ainda tem de ser processado
+    if (skip > 0) {
+        // Nada aconteceu nesses ticks, por isso as tarefas nos cores só acumulam tempo
+        for (uint32_t c = 0; c < ncpus; c++) {
+            tick_core(&cores[c], command_queue, blocked_queue, current_time_ms, skip * TICKS_MS);
         }
     }
-    printf("Scheduler %s not recognized. Available options are:\n", name);
-    for (int i = 0; SCHEDULER_NAMES[i] != NULL; i++) {
-        // Lista cada opção disponível
-        printf(" - %s\n", SCHEDULER_NAMES[i]);
+    return current_time_ms + skip * TICKS_MS;
+}
+
+/**
+ * @brief Raise the soft limit of open files so that max_conns applications fit.
+ *
+ * Every connection takes one socket in the I/O thread, plus a few descriptors for
+ * the simulator itself. The soft limit is raised up to the hard limit at most.
+ *
+ * @param max_conns Maximum number of simultaneous connections
+ */
+static void raise_conn_limit(uint32_t max_conns) {
+    uint64_t wanted = (uint64_t) max_conns + SELF_FDS;   // sockets dos clientes + fds do próprio simulador
+    uint64_t limit = raise_fd_limit(wanted);
+    if (limit != 0 && limit < wanted) {
+        fprintf(stderr, "Open file limit is %llu: only about %llu applications can connect at once\n",
+                (unsigned long long) limit, (unsigned long long) (limit > SELF_FDS ? limit - SELF_FDS : 0));
+    }
+}
+
+static void request_stop(int sig) {
+    (void) sig;
+    stop_requested = 1;
+    io_wake();      // o tick thread pode estar a dormir em io_wait
+}
+
+/**
+ * @brief Print the counters of the reply batches written by the I/O thread.
+ */
+static void print_io_stats(void) {
+    io_stats_t st;
+    io_get_stats(&st);
+    printf("Replies: %llu in %llu batches (avg %.1f, max %u), %llu writes, up to %u replies per write\n",
+           (unsigned long long) st.replies, (unsigned long long) st.batches,
+           st.batches ? (double) st.replies / (double) st.batches : 0.0, st.max_batch,
+           (unsigned long long) st.writes, st.max_coalesced);
+    printf("Batch sizes:");
+    for (int i = 0; i < IO_BATCH_BUCKETS; i++) {
+        if (i == 0) {
+            printf(" 1: %llu", (unsigned long long) st.batch_hist[i]);
+        } else if (i == IO_BATCH_BUCKETS - 1) {
+            printf(" %u+: %llu", 1u << i, (unsigned long long) st.batch_hist[i]);
+        } else {
+            printf(" %u-%u: %llu", 1u << i, (2u << i) - 1, (unsigned long long) st.batch_hist[i]);
+        }
     }
-    return NULL_SCHEDULER;
+    printf("\n");
+}
+
+static void usage(const char *prog) {
+    printf("Usage: %s [--virtual-time | --tickless] [--cpus N] [--max-procs N] [--backlog N] [--sched-options OPTS] <scheduler>\nScheduler options: FIFO, SJF, RR, MLFQ or path/to/policy.so\n", prog);
+    printf("  --virtual-time  advance the clock straight to the next event when all clients wait for a reply\n");
+    printf("  --tickless      real time, but sleep until the next event or message instead of waking every tick\n");
+    printf("  --cpus N        simulate N cores, each with its own run queue (default 1)\n");
+    printf("  --max-procs N   preallocate pcbs for N simultaneous applications (default %u, max %u)\n",
+           PCB_POOL_DEFAULT_CAPACITY, MAX_PROCS);
+    printf("  --sched-options OPTS  policy options, e.g. MLFQ: levels=4,quanta=100:200:400:800,boost=5000\n");
+    printf("  --backlog N     connections waiting to be accepted (default %d, capped by net.core.somaxconn)\n", DEFAULT_BACKLOG);
+}
+
+/**
+ * @brief Parse the value of a numeric option, rejecting trailing garbage and values out of range.
+ *
+ * @param arg The value given on the command line
+ * @param min The smallest value accepted
+ * @param max The largest value accepted
+ * @param value Set to the value parsed
+ * @return 0 on success, -1 if arg is not a number between min and max
+ */
+static int parse_number(const char *arg, long min, long max, long *value) {
+    char *end;
+    errno = 0;
+    long v = strtol(arg, &end, 10);
+    if (errno != 0 || end == arg || *end != '\0' || v < min || v > max) return -1;
+    *value = v;
+    return 0;
 }
 
 int main(int argc, char *argv[]) {
-    // Verifica se o número de argumentos está correto (deve ser 2)
-    if (argc != 2) {
-        printf("Usage: %s <scheduler>\nScheduler options: FIFO", argv[0]);
+    int virtual_time = 0;   // 1 if the clock skips over ticks in which nothing happens
+    int tickless = 0;       // 1 to sleep until the next event instead of waking up every tick
+    uint32_t max_procs = PCB_POOL_DEFAULT_CAPACITY;   // size of the pcb slab
+    const char *sched_options = NULL;   // options passed to the scheduling policy
+    int backlog = DEFAULT_BACKLOG;      // pending connections accepted by listen()
+    static const struct option long_options[] = {
+        {"virtual-time", no_argument, NULL, 'v'},
+        {"tickless", no_argument, NULL, 't'},
+        {"max-procs", required_argument, NULL, 'p'},
+        {"cpus", required_argument, NULL, 'c'},
+        {"sched-options", required_argument, NULL, 'o'},
+        {"backlog", required_argument, NULL, 'b'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    long value;
+    while ((opt = getopt_long(argc, argv, "vtp:o:c:b:", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'v':
+                virtual_time = 1;
+                break;
+            case 't':
+                tickless = 1;
+                break;
+            case 'p':
+                if (parse_number(optarg, 1, MAX_PROCS, &value) < 0) {
+                    fprintf(stderr, "--max-procs must be between 1 and %u\n", MAX_PROCS);
+                    usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                max_procs = (uint32_t) value;
+                break;
+            case 'c':
+                if (parse_number(optarg, 1, MAX_CPUS, &value) < 0) {
+                    fprintf(stderr, "--cpus must be between 1 and %d\n", MAX_CPUS);
+                    usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                ncpus = (uint32_t) value;
+                break;
+            case 'o':
+                sched_options = optarg;
+                break;
+            case 'b':
+                if (parse_number(optarg, 1, INT_MAX, &value) < 0) {
+                    fprintf(stderr, "--backlog must be between 1 and %d\n", INT_MAX);
+                    usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                backlog = (int) value;
+                break;
+            default:
+                usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    // Verifica se o número de argumentos está correto (deve ser 1 além das opções)
+    if (argc - optind != 1 || (virtual_time && tickless)) {
+        usage(argv[0]);
         exit(EXIT_FAILURE);
     }
 
-    // Parse arguments
-    scheduler_en scheduler_type = get_scheduler(argv[1]);   // Analisa o argumento e obtém o tipo de escalonador
-    if (scheduler_type == NULL_SCHEDULER) {  // Se o tipo for inválido, encerra o programa com erro
+    if (pcb_pool_init(max_procs) < 0) {
         return EXIT_FAILURE;
     }
 
-    // We set up 3 queues: 1 for the simulator and 2 for scheduling
-    // - COMMAND queue: for PCBs that are waiting for (new) instructions from the app
-    // - READY queue: for PCBs that are ready to run on the CPU
-    // - BLOCKED queue: for PCBs that are blocked waiting for I/O
-    queue_t command_queue = {.head = NULL, .tail = NULL};  // Inicializa a fila de comandos vazia
-    queue_t ready_queue = {.head = NULL, .tail = NULL};     // Inicializa a fila de prontos vazia
-    queue_t blocked_queue = {.head = NULL, .tail = NULL};  // Inicializa a fila de bloqueados vazia
+    // Parse arguments: each core gets its own instance of the scheduling policy
+    cores = calloc(ncpus, sizeof(core_t));
+    if (!cores) {
+        perror("calloc");
+        return EXIT_FAILURE;
+    }
+    for (uint32_t c = 0; c < ncpus; c++) {
+        if (scheduler_create(&cores[c].sched, argv[optind], sched_options) < 0) {  // Se a política for inválida, encerra o programa com erro
+            return EXIT_FAILURE;
+        }
+    }
 
-    // We only have a single CPU that is a pointer to the actively running PCB on the CPU
-    pcb_t *CPU = NULL;
+    // We set up 2 queues for the simulator, the ready tasks are kept by the scheduling policy
+    // - COMMAND queue: for PCBs that are waiting for (new) instructions from the app
+    // - BLOCKED queue: for PCBs that are blocked waiting for I/O (a timing wheel keyed by wake-up time)
+    queue_t command_queue = {.head = PCB_HANDLE_NONE, .tail = PCB_HANDLE_NONE};  // Inicializa a fila de comandos vazia
+    timer_wheel_t blocked_queue;
+    timer_wheel_init(&blocked_queue);   // Inicializa a roda de bloqueados vazia
 
-    int server_fd = setup_server_socket(SOCKET_PATH);  // cria e inicializa o socket do server
+    raise_conn_limit(max_procs);
+    int server_fd = setup_server_socket(SOCKET_PATH, backlog);  // cria e inicializa o socket do server
     if (server_fd < 0) {
         fprintf(stderr, "Failed to set up server socket\n");
         return 1;
     }
-
-    if (scheduler_type == SCHED_MLFQ) {  // Se o escalonador selecionado for MLFQ
-
-        mq = create_mlfq();  // cria estrutura
-        if (!mq) {
-            fprintf(stderr, "Failed to create MLFQ\n");
-            return 1;
-        }
+    conn_pcb = calloc((size_t) max_procs + 1, sizeof(pcb_handle_t));  // uma ligação por pcb, no máximo
+    conn_shm = calloc((size_t) max_procs + 1, sizeof(shm_endpoint_t *));
+    pcb_script = calloc(max_procs, sizeof(script_t *));
+    if (!conn_pcb || !conn_shm || !pcb_script || io_thread_start(server_fd, max_procs) < 0) {
+        fprintf(stderr, "Failed to start the I/O thread\n");
+        close(server_fd);
+        return 1;
     }
 
     printf("Scheduler server listening on %s...\n", SOCKET_PATH);
     uint32_t current_time_ms = 0;  // Inicializa o relógio do simulador em milissegundos
 
-    while (1) {
+    uint32_t reported_s = UINT32_MAX;  // Último segundo impresso
+    uint64_t reported_overruns = 0;    // Overruns já reportados
+
+    int timer_fd = -1;     // acorda o modo tickless no tick do próximo evento
+    if (tickless && (timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0) {
+        perror("timerfd_create");
+        return 1;
+    }
+    tick_clock_init(&tick_clock);
+    signal(SIGINT, request_stop);
+    signal(SIGTERM, request_stop);
+    while (!stop_requested) {
         // Verifica novas conexões e/ou comandos recebidos
-        check_new_commands(&command_queue, &blocked_queue, &ready_queue, server_fd, current_time_ms);
+        check_new_commands(&command_queue, &blocked_queue, current_time_ms);
 
-        if (current_time_ms%1000 == 0) {  // A cada segundo, imprime o tempo atual
-            printf("Current time: %d s\n", current_time_ms/1000);
+        if (current_time_ms/1000 != reported_s) {  // A cada segundo, imprime o tempo atual
+            reported_s = current_time_ms/1000;
+            if (tick_clock.overruns != reported_overruns) {    // o simulador não está a conseguir acompanhar
+                printf("Current time: %d s (%llu tick overruns so far)\n", reported_s, (unsigned long long) tick_clock.overruns);
+                reported_overruns = tick_clock.overruns;
+            } else {
+                printf("Current time: %d s\n", reported_s);
+            }
         }
         // Check the status of the PCBs in the blocked queue
         check_blocked_queue(&blocked_queue, &command_queue, current_time_ms);
-        // Tasks from the blocked queue could be moved to the command queue, check again
-        usleep(TICKS_MS * 1000/2);
-        check_new_commands(&command_queue, &blocked_queue, &ready_queue, server_fd, current_time_ms);
-
-        // Seleciona e executa o algoritmo de escalonamento conforme o tipo escolhido
-        switch (scheduler_type) {
-            case SCHED_FIFO:
-                fifo_scheduler(current_time_ms, &ready_queue, &CPU); // executa o scheduler FIFO
-                break;
-            case SCHED_SJF:
-                sjf_scheduler(current_time_ms, &ready_queue, &CPU);  // executa o scheduler SJF
-                break;
-            case SCHED_RR:
-                rr_scheduler(current_time_ms,&ready_queue,&CPU);  // executa o scheduler RR
-                break;
-            case SCHED_MLFQ:
-                mlfq_scheduler(current_time_ms, mq, &CPU);  // executa o scheduler MLFQ
-                break;
-
-            default:
-                printf("Unknown scheduler type\n");
-                break;
+        // Tasks from the blocked queue could be moved to the command queue, check again.
+        // In virtual time we only wait (in real time) for clients that still owe us a request.
+        if (!tickless && (!virtual_time || !queue_empty(&command_queue))) {
+            tick_clock_wait(&tick_clock, current_time_ms + TICKS_MS/2, 0);
+        } else if (virtual_time) {
+            tick_clock_skip(&tick_clock, TICKS_MS/2);
         }
+        check_new_commands(&command_queue, &blocked_queue, current_time_ms);
 
+        // Executa a política de escalonamento escolhida em cada core
+        int idle = (blocked_queue.count == 0);
+        for (uint32_t c = 0; c < ncpus; c++) {
+            tick_core(&cores[c], &command_queue, &blocked_queue, current_time_ms, TICKS_MS);
+        }
+        dispatch_cores(current_time_ms);
+        io_flush();     // envia os DONEs deste tick
+        for (uint32_t c = 0; c < ncpus; c++) {
+            if (cores[c].running) idle = 0;
+        }
         // Simulate a tick
-        usleep(TICKS_MS * 1000/2);
+        if (!tickless && (!virtual_time || !queue_empty(&command_queue) || idle)) {
+            tick_clock_wait(&tick_clock, current_time_ms + TICKS_MS, 1);
+        } else if (virtual_time) {
+            tick_clock_skip(&tick_clock, TICKS_MS/2);
+        }
         current_time_ms += TICKS_MS;   // Incrementa o relógio do simulador
+
+        // Tickless: sleep until the tick of the next event, or until a message arrives
+        if (tickless) {
+            current_time_ms = tickless_wait(timer_fd, &command_queue, &blocked_queue, current_time_ms);
+        }
+
+        // Every client is waiting for a reply: jump straight to the tick of the next event
+        if (virtual_time && queue_empty(&command_queue) && !idle) {
+            uint32_t ticks = ticks_to_next_event(&blocked_queue, current_time_ms);
+            if (ticks > 1) {
+                // Nada acontece até lá, por isso as tarefas nos cores só acumulam tempo
+                for (uint32_t c = 0; c < ncpus; c++) {
+                    tick_core(&cores[c], &command_queue, &blocked_queue, current_time_ms, (ticks - 1) * TICKS_MS);
+                }
+                current_time_ms += (ticks - 1) * TICKS_MS;
+                tick_clock_skip(&tick_clock, (ticks - 1) * TICKS_MS);
+            }
+        }
+
+        // Nothing to simulate: sleep until an application connects, then resume the clock at the current real time
+        if (!tickless && simulator_idle(&command_queue, &blocked_queue)) {
+            io_wait(-1);
+            tick_clock_resume(&tick_clock);
+            uint32_t now_ms = tick_clock_now_ms(&tick_clock) / TICKS_MS * TICKS_MS;
+            if (now_ms > current_time_ms) current_time_ms = now_ms;
+        }
     }
 
-    // Unreachable, because of the infinite loop!!!!
+    print_io_stats();
+    tick_clock_print_stats(&tick_clock, stdout);
     return 0;
 }
@@ -0,0 +1,89 @@
+#include "pcb_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FREE_LIST_END UINT32_MAX
+
+// The slab: one contiguous array of pcbs, a freelist threaded through the
+// free slots and a high-water mark for slots that were never used
+static struct {
+    pcb_t *slots;
+    uint32_t capacity;      // Number of slots in the slab
+    uint32_t high_water;    // Slots at or above this index were never handed out
+    uint32_t free_head;     // First slot of the freelist (FREE_LIST_END if empty)
+    uint32_t in_use;        // Number of allocated pcbs
+} pool = {.free_head = FREE_LIST_END};
+
+int pcb_pool_init(uint32_t capacity) {
+    if (capacity == 0 || capacity > PCB_POOL_MAX_CAPACITY) {
+        fprintf(stderr, "Invalid pcb pool capacity %u (max %u)\n", capacity, PCB_POOL_MAX_CAPACITY);
+        return -1;
+    }
+    pcb_pool_destroy();
+    // calloc hands large blocks straight from mmap, so untouched slots cost no memory
+    pool.slots = calloc(capacity, sizeof(pcb_t));
+    if (!pool.slots) {
+        perror("calloc: pcb pool");
+        return -1;
+    }
+    pool.capacity = capacity;
+    return 0;
+}
+
+void pcb_pool_destroy(void) {
+    free(pool.slots);
+    pool.slots = NULL;
+    pool.capacity = pool.high_water = pool.in_use = 0;
+    pool.free_head = FREE_LIST_END;
+}
+
+pcb_t *pcb_pool_alloc(void) {
+    if (!pool.slots && pcb_pool_init(PCB_POOL_DEFAULT_CAPACITY) < 0) return NULL;
+
+    uint32_t index;
+    if (pool.free_head != FREE_LIST_END) {
+        index = pool.free_head;     // reuse a freed slot
+        pool.free_head = pool.slots[index].next;
+    } else if (pool.high_water < pool.capacity) {
+        index = pool.high_water++;  // first use of a slot
+    } else {
+        return NULL;    // pool exhausted
+    }
+
+    pcb_t *pcb = &pool.slots[index];
+    uint32_t generation = pcb->generation;
+    memset(pcb, 0, sizeof(pcb_t));
+    pcb->generation = (generation == 0) ? 1 : generation;    // generation 0 is never valid
+    pool.in_use++;
+    return pcb;
+}
+
+void pcb_pool_free(pcb_t *pcb) {
+    if (!pcb) return;
+    uint32_t index = (uint32_t)(pcb - pool.slots);
+    pcb->status = TASK_TERMINATED;
+    pcb->generation = (pcb->generation + 1) & PCB_GEN_MASK;
+    if (pcb->generation == 0) pcb->generation = 1;
+    pcb->next = pool.free_head;     // the freelist reuses the queue link
+    pool.free_head = index;
+    pool.in_use--;
+}
+
+pcb_handle_t pcb_handle(const pcb_t *pcb) {
+    uint32_t index = (uint32_t)(pcb - pool.slots);
+    return (pcb->generation << PCB_INDEX_BITS) | index;
+}
+
+pcb_t *pcb_get(pcb_handle_t handle) {
+    if (handle == PCB_HANDLE_NONE) return NULL;
+    uint32_t index = handle & PCB_INDEX_MASK;
+    if (index >= pool.high_water) return NULL;
+    pcb_t *pcb = &pool.slots[index];
+    return (pcb->generation == handle >> PCB_INDEX_BITS) ? pcb : NULL;
+}
+
+uint32_t pcb_pool_in_use(void) {
+    return pool.in_use;
+}
@@ -0,0 +1,76 @@
+#ifndef PCB_POOL_H
+#define PCB_POOL_H
+
+#include <stdint.h>
+
+#include "queue.h"
+
+// A pcb handle holds the slot index in its low PCB_INDEX_BITS bits and the
+// generation of the slot in the remaining high bits. Every time a slot is
+// freed its generation changes, so handles to a freed pcb no longer resolve.
+#define PCB_INDEX_BITS  20
+#define PCB_INDEX_MASK  ((1u << PCB_INDEX_BITS) - 1)
+#define PCB_GEN_BITS    (32 - PCB_INDEX_BITS)
+#define PCB_GEN_MASK    ((1u << PCB_GEN_BITS) - 1)
+
+#define PCB_POOL_MAX_CAPACITY     (1u << PCB_INDEX_BITS)   // 1M pcbs
+#define PCB_POOL_DEFAULT_CAPACITY 65536
+
+/**
+ * @brief Preallocate the pcb slab
+ *
+ * All pcbs are taken from one contiguous block of capacity pcbs. The block
+ * is reserved up front but only touched as slots are used. If this function
+ * is not called, the first allocation sets up a pool of
+ * PCB_POOL_DEFAULT_CAPACITY pcbs.
+ *
+ * @param capacity Maximum number of live pcbs (at most PCB_POOL_MAX_CAPACITY)
+ * @return 0 on success, -1 on failure
+ */
+int pcb_pool_init(uint32_t capacity);
+
+/**
+ * @brief Release the pcb slab
+ *
+ * All handles and pcb pointers become invalid.
+ */
+void pcb_pool_destroy(void);
+
+/**
+ * @brief Take a pcb from the slab in O(1)
+ *
+ * @return A zeroed pcb, or NULL if the pool is exhausted
+ */
+pcb_t *pcb_pool_alloc(void);
+
+/**
+ * @brief Give a pcb back to the slab in O(1)
+ *
+ * The generation of the slot changes, so existing handles to it stop resolving.
+ *
+ * @param pcb The pcb to be freed (must not be in any queue)
+ */
+void pcb_pool_free(pcb_t *pcb);
+
+/**
+ * @brief Get the handle of a live pcb
+ *
+ * @param pcb The pcb
+ * @return The handle of the pcb (never PCB_HANDLE_NONE)
+ */
+pcb_handle_t pcb_handle(const pcb_t *pcb);
+
+/**
+ * @brief Resolve a handle to its pcb
+ *
+ * @param handle The handle to resolve
+ * @return The pcb, or NULL if the handle is PCB_HANDLE_NONE or refers to a freed pcb
+ */
+pcb_t *pcb_get(pcb_handle_t handle);
+
+/**
+ * @brief Number of pcbs currently allocated from the slab
+ */
+uint32_t pcb_pool_in_use(void);
+
+#endif //PCB_POOL_H
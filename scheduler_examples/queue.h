@@ -10,6 +10,11 @@ typedef enum  {
     TASK_TERMINATED,    // Task has been terminated and will be removed
 } task_status_en;
 
+// Handle of a pcb in the pcb slab (see pcb_pool.h). Queues link pcbs through
+// handles, so a stale link to a freed pcb resolves to NULL instead of reused memory.
+typedef uint32_t pcb_handle_t;
+#define PCB_HANDLE_NONE 0
+
 // Define the Process Control Block (PCB) structure
 typedef struct pcb_st{
     int32_t pid;                   // Process ID
@@ -17,42 +22,52 @@ typedef struct pcb_st{
     uint32_t time_ms;              // Time requested by application in milliseconds
     uint32_t ellapsed_time_ms;     // Time ellapsed since start in milliseconds
     uint32_t slice_start_ms;       // Time when the current time slice started
-    uint32_t sockfd;               // Socket file descriptor for communication with the application
+    uint32_t conn;                 // Connection id (conn_id_t) of the application, 0 once it went away
     uint32_t last_update_time_ms;  // Last time the PCB was updataed
+    uint32_t wake_time_ms;         // Absolute time at which a blocked task wakes up
     uint32_t slice_time; //Variavel para a slice
     int priority_level; //prioridade MLFQ nao dá
+    uint32_t generation;           // Generation of the slab slot holding this pcb
+    pcb_handle_t prev;             // Previous pcb in the queue holding this pcb
+    pcb_handle_t next;             // Next pcb in the queue holding this pcb
 } pcb_t;
 
-// Define singly linked list elements
-typedef struct queue_elem_st queue_elem_t;
-typedef struct queue_elem_st {
-    pcb_t *pcb;
-    queue_elem_t *next;
-} queue_elem_t;
-
 // Define the queue structure
+// The queue is an intrusive doubly linked list: the links live inside the pcbs,
+// so moving a pcb between queues allocates nothing. A pcb can only be in one
+// queue at a time. A zero-initialized queue_t is a valid empty queue.
 // We define the head and the tail to make it easier to enqueue and dequeue
 typedef struct queue_st  {
-    queue_elem_t* head;
-    queue_elem_t* tail;
+    pcb_handle_t head;
+    pcb_handle_t tail;
 } queue_t;
 
 /**
  * @brief Create a new pcb (process control block)
  *
- * This function allocates memory for a new pcb and initializes its fields.
+ * This function takes a new pcb from the pcb slab and initializes its fields.
  *
  * @param pid The process ID of the task
- * @param sockfd The socket file descriptor for communication with the application
+ * @param conn The connection id (conn_id_t) of the application
  * @param time_ms a time field (either for run or block)
  * @return
  */
-pcb_t *new_pcb(int32_t pid, uint32_t sockfd, uint32_t time_ms);
+pcb_t *new_pcb(int32_t pid, uint32_t conn, uint32_t time_ms);
+
+/**
+ * @brief Free a pcb (process control block)
+ *
+ * This function gives the pcb back to the pcb slab. Handles to it stop resolving.
+ *
+ * @param pcb The pcb to be freed (must not be in any queue)
+ */
+void free_pcb(pcb_t *pcb);
 
 /**
  * @brief Enqueue a pcb into the queue
  *
- * This function adds a pcb to the end of the queue (FIFO order).
+ * This function adds a pcb to the end of the queue (FIFO order) in O(1),
+ * without allocating memory.
  *
  * @param q The queue to which the pcb will be added
  * @param task The pcb to be added to the queue
@@ -71,26 +86,53 @@ int enqueue_pcb(queue_t* q, pcb_t* task);
 pcb_t* dequeue_pcb(queue_t* q);
 
 /**
- * @brief Dequeue a pcb from the queue
+ * @brief Remove a specific pcb from the queue
  *
- * This function removes and returns the pcb at the front of the queue (FIFO order).
+ * This function unlinks the pcb from the queue in O(1). The pcb must be in
+ * the given queue. The pcb itself is not freed.
  *
- * @param q The queue from which the task will be removed
+ * @param q The queue from which the pcb will be removed
+ * @param pcb The pcb to be removed from the queue
+ * @return The removed pcb
+ */
+pcb_t *remove_pcb(queue_t* q, pcb_t* pcb);
+
+/**
+ * @brief Move all elements of a queue to the end of another queue
+ *
+ * The pcbs are relinked in O(1), keeping their order. The source queue
+ * is left empty.
+ *
+ * @param dst The queue to which the elements will be appended
+ * @param src The queue whose elements will be moved
+ */
+void append_queue(queue_t* dst, queue_t* src);
+
+/**
+ * @brief Check if a queue is empty
+ *
+ * @param q The queue to check
+ * @return 1 if the queue is empty, 0 otherwise
+ */
+int queue_empty(const queue_t* q);
+
+/**
+ * @brief Get the first pcb of a queue without removing it
+ *
+ * @param q The queue
  * @return The pcb at the front of the queue, or NULL if the queue is empty
  */
-pcb_t* dequeue_short(queue_t* q);
+pcb_t* queue_head(const queue_t* q);
 
 /**
- * @brief Remove a specific element from the queue
+ * @brief Get the pcb that follows a pcb in its queue
  *
- * This function removes a specific element from the queue.
- * Neither the element, nor the pcb inside the element, are freed.
+ * Together with queue_head() this walks a queue from front to back.
  *
- * @param q The queue from which the element will be removed
- * @param elem The element to be removed from the queue
- * @return The removed element, or NULL if the element was not found
+ * @param pcb A pcb that is in a queue
+ * @return The next pcb in the queue, or NULL if pcb is the last one
  */
-queue_elem_t *remove_queue_elem(queue_t* q, queue_elem_t* elem);
+pcb_t* queue_next(const pcb_t* pcb);
 
 
 #endif //QUEUE_H
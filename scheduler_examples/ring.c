@@ -0,0 +1,127 @@
+#include "ring.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static int is_power_of_two(uint32_t x) {
+    return x != 0 && (x & (x - 1)) == 0;
+}
+
+size_t spsc_ring_bytes(uint32_t capacity, uint32_t elem_size) {
+    return sizeof(spsc_ring_t) + (size_t) capacity * elem_size;
+}
+
+spsc_ring_t *spsc_ring_init(void *mem, uint32_t capacity, uint32_t elem_size) {
+    if (!is_power_of_two(capacity)) return NULL;
+    spsc_ring_t *ring = mem;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->mask = capacity - 1;
+    ring->elem_size = elem_size;
+    return ring;
+}
+
+// mask e elem_size vêm do chamador: o cabeçalho do ring só é lido pelas versões confiáveis
+static int spsc_push(spsc_ring_t *ring, const void *elem, uint32_t mask, uint32_t elem_size) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    if (tail - head > mask) return 0;     // cheio
+    memcpy(ring->slots + (size_t) (tail & mask) * elem_size, elem, elem_size);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);   // publica o elemento
+    return 1;
+}
+
+static int spsc_pop(spsc_ring_t *ring, void *elem, uint32_t mask, uint32_t elem_size) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head == tail) return 0;     // vazio
+    memcpy(elem, ring->slots + (size_t) (head & mask) * elem_size, elem_size);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);   // liberta o slot
+    return 1;
+}
+
+int spsc_ring_push(spsc_ring_t *ring, const void *elem) {
+    return spsc_push(ring, elem, ring->mask, ring->elem_size);
+}
+
+int spsc_ring_pop(spsc_ring_t *ring, void *elem) {
+    return spsc_pop(ring, elem, ring->mask, ring->elem_size);
+}
+
+int spsc_ring_push_sized(spsc_ring_t *ring, const void *elem, uint32_t capacity, uint32_t elem_size) {
+    return spsc_push(ring, elem, capacity - 1, elem_size);
+}
+
+int spsc_ring_pop_sized(spsc_ring_t *ring, void *elem, uint32_t capacity, uint32_t elem_size) {
+    return spsc_pop(ring, elem, capacity - 1, elem_size);
+}
+
+int spsc_ring_empty(spsc_ring_t *ring) {
+    return atomic_load_explicit(&ring->head, memory_order_relaxed) ==
+           atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
+
+// Each MPSC slot is a sequence number followed by the element
+static _Atomic uint32_t *slot_seq(mpsc_ring_t *ring, uint32_t pos) {
+    return (_Atomic uint32_t *) (ring->slots + (size_t) (pos & ring->mask) * ring->slot_size);
+}
+
+static void *slot_data(mpsc_ring_t *ring, uint32_t pos) {
+    return ring->slots + (size_t) (pos & ring->mask) * ring->slot_size + sizeof(uint32_t);
+}
+
+mpsc_ring_t *mpsc_ring_create(uint32_t capacity, uint32_t elem_size) {
+    uint32_t cap = 1;
+    while (cap < capacity) cap <<= 1;
+    uint32_t slot_size = (uint32_t) ((sizeof(uint32_t) + elem_size + sizeof(uint32_t) - 1) & ~(sizeof(uint32_t) - 1));
+    size_t bytes = sizeof(mpsc_ring_t) + (size_t) cap * slot_size;
+    bytes = (bytes + RING_CACHE_LINE - 1) & ~(size_t) (RING_CACHE_LINE - 1);
+    mpsc_ring_t *ring = aligned_alloc(RING_CACHE_LINE, bytes);
+    if (!ring) return NULL;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->mask = cap - 1;
+    ring->elem_size = elem_size;
+    ring->slot_size = slot_size;
+    for (uint32_t i = 0; i < cap; i++) {
+        atomic_init(slot_seq(ring, i), i);    // o slot i está livre para a posição i
+    }
+    return ring;
+}
+
+int mpsc_ring_push(mpsc_ring_t *ring, const void *elem) {
+    uint32_t pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    for (;;) {
+        uint32_t seq = atomic_load_explicit(slot_seq(ring, pos), memory_order_acquire);
+        int32_t diff = (int32_t) (seq - pos);
+        if (diff == 0) {
+            // O slot está livre: tenta reservá-lo (pos é atualizado se outro produtor ganhou)
+            if (atomic_compare_exchange_weak_explicit(&ring->tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return 0;   // cheio: o consumidor ainda não leu este slot
+        } else {
+            pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        }
+    }
+    memcpy(slot_data(ring, pos), elem, ring->elem_size);
+    atomic_store_explicit(slot_seq(ring, pos), pos + 1, memory_order_release);   // publica o elemento
+    return 1;
+}
+
+int mpsc_ring_pop(mpsc_ring_t *ring, void *elem) {
+    uint32_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t seq = atomic_load_explicit(slot_seq(ring, pos), memory_order_acquire);
+    if (seq != pos + 1) return 0;   // vazio (ou o produtor ainda está a copiar)
+    memcpy(elem, slot_data(ring, pos), ring->elem_size);
+    atomic_store_explicit(slot_seq(ring, pos), pos + ring->mask + 1, memory_order_release);  // livre na próxima volta
+    atomic_store_explicit(&ring->head, pos + 1, memory_order_relaxed);
+    return 1;
+}
+
+int mpsc_ring_empty(mpsc_ring_t *ring) {
+    uint32_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    return atomic_load_explicit(slot_seq(ring, pos), memory_order_acquire) != pos + 1;
+}
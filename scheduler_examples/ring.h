@@ -0,0 +1,117 @@
+#ifndef RING_H
+#define RING_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define RING_CACHE_LINE 64
+
+// Define a bounded single-producer single-consumer ring
+// The header and the slots live in one block without pointers, so a ring can be
+// placed in memory shared between processes. head is only written by the consumer
+// and tail only by the producer, each on its own cache line.
+typedef struct spsc_ring_st {
+    _Alignas(RING_CACHE_LINE) _Atomic uint32_t head;    // Next slot to read (consumer)
+    _Alignas(RING_CACHE_LINE) _Atomic uint32_t tail;    // Next slot to write (producer)
+    _Alignas(RING_CACHE_LINE) uint32_t mask;            // Capacity - 1 (capacity is a power of two)
+    uint32_t elem_size;                                 // Size of one element in bytes
+    _Alignas(RING_CACHE_LINE) unsigned char slots[];
+} spsc_ring_t;
+
+// Define a bounded multi-producer single-consumer ring
+// Every slot carries a sequence number (Vyukov's bounded queue), so producers only
+// contend on the tail counter and never wait for each other to finish a copy.
+typedef struct mpsc_ring_st {
+    _Alignas(RING_CACHE_LINE) _Atomic uint32_t head;    // Next slot to read (consumer)
+    _Alignas(RING_CACHE_LINE) _Atomic uint32_t tail;    // Next slot to claim (producers)
+    _Alignas(RING_CACHE_LINE) uint32_t mask;            // Capacity - 1 (capacity is a power of two)
+    uint32_t elem_size;                                 // Size of one element in bytes
+    uint32_t slot_size;                                 // Sequence number plus element, aligned
+    _Alignas(RING_CACHE_LINE) unsigned char slots[];
+} mpsc_ring_t;
+
+/**
+ * @brief Bytes needed by an SPSC ring of capacity elements of elem_size bytes
+ *
+ * @param capacity Number of elements (must be a power of two)
+ * @param elem_size Size of one element in bytes
+ */
+size_t spsc_ring_bytes(uint32_t capacity, uint32_t elem_size);
+
+/**
+ * @brief Initialize an SPSC ring in a block of spsc_ring_bytes() bytes
+ *
+ * @return The ring, or NULL if capacity is not a power of two
+ */
+spsc_ring_t *spsc_ring_init(void *mem, uint32_t capacity, uint32_t elem_size);
+
+/**
+ * @brief Append an element (producer only)
+ *
+ * @return 1 on success, 0 if the ring is full
+ */
+int spsc_ring_push(spsc_ring_t *ring, const void *elem);
+
+/**
+ * @brief Remove the oldest element (consumer only)
+ *
+ * @return 1 on success, 0 if the ring is empty
+ */
+int spsc_ring_pop(spsc_ring_t *ring, void *elem);
+
+/**
+ * @brief Append an element (producer only), with the layout given by the caller
+ *
+ * For a ring in memory shared with an untrusted process: the capacity and element
+ * size in its header are never read, so rewriting them has no effect.
+ *
+ * @param capacity Number of elements the ring was initialized with
+ * @param elem_size Size of one element in bytes
+ * @return 1 on success, 0 if the ring is full
+ */
+int spsc_ring_push_sized(spsc_ring_t *ring, const void *elem, uint32_t capacity, uint32_t elem_size);
+
+/**
+ * @brief Remove the oldest element (consumer only), with the layout given by the caller
+ *
+ * For a ring in memory shared with an untrusted process, like spsc_ring_push_sized.
+ *
+ * @return 1 on success, 0 if the ring is empty
+ */
+int spsc_ring_pop_sized(spsc_ring_t *ring, void *elem, uint32_t capacity, uint32_t elem_size);
+
+/**
+ * @brief Check if the ring is empty
+ */
+int spsc_ring_empty(spsc_ring_t *ring);
+
+/**
+ * @brief Allocate an MPSC ring of capacity elements of elem_size bytes
+ *
+ * @param capacity Number of elements (rounded up to a power of two)
+ * @param elem_size Size of one element in bytes
+ * @return The ring (release with free()), or NULL on failure
+ */
+mpsc_ring_t *mpsc_ring_create(uint32_t capacity, uint32_t elem_size);
+
+/**
+ * @brief Append an element (any producer)
+ *
+ * @return 1 on success, 0 if the ring is full
+ */
+int mpsc_ring_push(mpsc_ring_t *ring, const void *elem);
+
+/**
+ * @brief Remove the oldest published element (consumer only)
+ *
+ * @return 1 on success, 0 if the ring is empty
+ */
+int mpsc_ring_pop(mpsc_ring_t *ring, void *elem);
+
+/**
+ * @brief Check if the ring has no published element (consumer only)
+ */
+int mpsc_ring_empty(mpsc_ring_t *ring);
+
+#endif //RING_H
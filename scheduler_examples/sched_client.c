@@ -0,0 +1,272 @@
+#include "sched_client.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Pass the memfd of the channel with a PROCESS_REQUEST_SHM message and wait for the ACK
+static int shm_handshake(sched_client_t *client) {
+    int fd;
+    client->shm = shm_channel_create(&fd);
+    if (!client->shm) return -1;
+
+    msg_t msg = {.pid = getpid(), .request = PROCESS_REQUEST_SHM, .time_ms = 0};
+    struct iovec iov = {.iov_base = &msg, .iov_len = sizeof(msg_t)};
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct msghdr mh = {
+        .msg_iov = &iov,
+        .msg_iovlen = 1,
+        .msg_control = control.buf,
+        .msg_controllen = sizeof(control.buf)
+    };
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&mh);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    ssize_t n = sendmsg(client->sockfd, &mh, 0);
+    close(fd);      // the mapping stays valid, the scheduler has its own copy of the fd
+    if (n != sizeof(msg_t)) {
+        perror("sendmsg");
+        return -1;
+    }
+    if (read(client->sockfd, &msg, sizeof(msg_t)) != sizeof(msg_t) || msg.request != PROCESS_REQUEST_ACK) {
+        fprintf(stderr, "The scheduler refused the shared-memory channel\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Read exactly len bytes from the socket
+static int read_all(int fd, void *buf, size_t len) {
+    unsigned char *p = buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n <= 0) {
+            if (n < 0) perror("read");
+            return -1;
+        }
+        p += n;
+        len -= (size_t) n;
+    }
+    return 0;
+}
+
+// Write all len bytes, a frame may not fit in the socket buffer at once
+static int write_all(int fd, const void *buf, size_t len) {
+    const unsigned char *p = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n <= 0) {
+            perror("write");
+            return -1;
+        }
+        p += n;
+        len -= (size_t) n;
+    }
+    return 0;
+}
+
+int sched_client_connect(sched_client_t *client, int use_shm) {
+    client->shm = NULL;
+    client->version = PROTOCOL_V1;
+    client->seq = 0;
+    client->skip_acks = 0;
+    client->sockfd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (client->sockfd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    struct sockaddr_un addr = {0};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, SOCKET_PATH, sizeof(addr.sun_path) - 1);
+
+    if (connect(client->sockfd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("connect");
+        sched_client_close(client);
+        return -1;
+    }
+    if (use_shm && shm_handshake(client) < 0) {
+        sched_client_close(client);
+        return -1;
+    }
+    return 0;
+}
+
+int sched_client_hello(sched_client_t *client) {
+    if (client->shm) {
+        fprintf(stderr, "Protocol v2 is only spoken over the socket\n");
+        return -1;
+    }
+    msg_t msg = {.pid = getpid(), .request = PROCESS_REQUEST_HELLO, .time_ms = PROTOCOL_V2};
+    if (write_all(client->sockfd, &msg, sizeof(msg_t)) < 0 || read_all(client->sockfd, &msg, sizeof(msg_t)) < 0) {
+        return -1;
+    }
+    if (msg.request != PROCESS_REQUEST_ACK) {
+        fprintf(stderr, "The scheduler did not answer the HELLO\n");
+        return -1;
+    }
+    client->version = (msg.time_ms >= PROTOCOL_V2) ? PROTOCOL_V2 : PROTOCOL_V1;
+    return client->version;
+}
+
+int sched_client_send(sched_client_t *client, const msg_t *msg) {
+    return sched_client_send_flags(client, msg, 0);
+}
+
+int sched_client_send_flags(sched_client_t *client, const msg_t *msg, uint16_t flags) {
+    if (client->version < PROTOCOL_V2 && (flags & MSG_FLAG_NO_ACK)) {
+        client->skip_acks++;    // v1 always sends the ACK
+    }
+    if (client->shm) {
+        if (!shm_channel_send_request(client->shm, msg)) {
+            fprintf(stderr, "Shared-memory request ring is full\n");
+            return -1;
+        }
+        return 0;
+    }
+    if (client->version < PROTOCOL_V2) {
+        return write_all(client->sockfd, msg, sizeof(msg_t));
+    }
+    struct {
+        msg_hdr_t hdr;
+        uint32_t time_ms;
+    } frame = {
+        .hdr = {.version = PROTOCOL_V2, .type = (uint8_t) msg->request, .flags = flags,
+                .seq = ++client->seq, .length = sizeof(uint32_t)},
+        .time_ms = msg->time_ms
+    };
+    return write_all(client->sockfd, &frame, sizeof(frame));
+}
+
+// Read the next reply; the payload of a REPORT is left for sched_client_recv_report
+static int recv_one(sched_client_t *client, msg_t *msg) {
+    if (client->shm) {
+        shm_channel_wait_reply(client->shm, msg);
+        return 0;
+    }
+    if (client->version < PROTOCOL_V2) {
+        return read_all(client->sockfd, msg, sizeof(msg_t));
+    }
+    msg_hdr_t hdr;
+    if (read_all(client->sockfd, &hdr, sizeof(hdr)) < 0) return -1;
+    if (hdr.version != PROTOCOL_V2) {
+        fprintf(stderr, "Invalid reply frame (version %u)\n", hdr.version);
+        return -1;
+    }
+    msg->pid = getpid();
+    msg->request = hdr.type;
+    msg->time_ms = hdr.length;
+    if (hdr.type == PROCESS_REQUEST_ACK || hdr.type == PROCESS_REQUEST_DONE) {
+        if (hdr.length != sizeof(uint32_t)) {
+            fprintf(stderr, "Invalid reply frame (%u bytes)\n", hdr.length);
+            return -1;
+        }
+        return read_all(client->sockfd, &msg->time_ms, sizeof(uint32_t));
+    }
+    return 0;
+}
+
+int sched_client_recv(sched_client_t *client, msg_t *msg) {
+    for (;;) {
+        if (recv_one(client, msg) < 0) return -1;
+        if (msg->request == PROCESS_REQUEST_ACK && client->skip_acks > 0) {
+            client->skip_acks--;    // ACK of a request that asked for none
+            continue;
+        }
+        return 0;
+    }
+}
+
+int sched_client_send_script(sched_client_t *client, const burst_queue_t *bursts, uint32_t flags) {
+    if (client->shm) {
+        fprintf(stderr, "Burst scripts are only supported over the socket\n");
+        return -1;
+    }
+    if (bursts->stream || bursts->dsl) {
+        fprintf(stderr, "Burst scripts need all the bursts loaded (see burst_queue_expand)\n");
+        return -1;
+    }
+    // Tamanho do payload: cabeçalho, bursts e respetivas páginas
+    size_t len = sizeof(script_header_t);
+    uint32_t count = 0;
+    burst_t scratch;
+    for (size_t i = bursts->next; i < bursts->count; i++) {
+        const burst_t *burst = burst_queue_get(bursts, i, &scratch);
+        if (!burst) {
+            fprintf(stderr, "Corrupted burst %zu\n", i);
+            return -1;
+        }
+        uint32_t pages = burst->pages.count < MAX_PAGES ? burst->pages.count : MAX_PAGES;
+        len += sizeof(script_burst_t) + pages * sizeof(uint32_t);
+        count++;
+    }
+    if (count == 0) {   // o escalonador rejeita scripts vazios
+        fprintf(stderr, "Burst script is empty\n");
+        return -1;
+    }
+    if (len > SCRIPT_MAX_BYTES) {
+        fprintf(stderr, "Burst script too large (%zu bytes, max %u)\n", len, SCRIPT_MAX_BYTES);
+        return -1;
+    }
+
+    size_t hdr_len = (client->version < PROTOCOL_V2) ? sizeof(msg_t) : sizeof(msg_hdr_t);
+    unsigned char *frame = malloc(hdr_len + len);
+    if (!frame) {
+        perror("malloc");
+        return -1;
+    }
+    unsigned char *p = frame;
+    if (client->version < PROTOCOL_V2) {
+        msg_t msg = {.pid = getpid(), .request = PROCESS_REQUEST_SCRIPT, .time_ms = (uint32_t) len};
+        memcpy(p, &msg, sizeof(msg_t));
+        p += sizeof(msg_t);
+    } else {
+        msg_hdr_t hdr = {.version = PROTOCOL_V2, .type = PROCESS_REQUEST_SCRIPT, .seq = ++client->seq, .length = (uint32_t) len};
+        memcpy(p, &hdr, sizeof(hdr));
+        p += sizeof(hdr);
+    }
+    script_header_t header = {.count = count, .flags = flags};
+    memcpy(p, &header, sizeof(header));
+    p += sizeof(header);
+    for (size_t i = bursts->next; i < bursts->count; i++) {
+        const burst_t *burst = burst_queue_get(bursts, i, &scratch);   // já validado acima
+        script_burst_t sb = {
+            .burst_time_ms = burst->burst_time_ms,
+            .block_time_ms = burst->block_time_ms,
+            .nice = burst->nice,
+            .page_count = burst->pages.count < MAX_PAGES ? burst->pages.count : MAX_PAGES
+        };
+        memcpy(p, &sb, sizeof(sb));
+        p += sizeof(sb);
+        memcpy(p, burst->pages.ids, sb.page_count * sizeof(uint32_t));
+        p += sb.page_count * sizeof(uint32_t);
+    }
+    int ret = write_all(client->sockfd, frame, (size_t) (p - frame));
+    free(frame);
+    return ret;
+}
+
+int sched_client_recv_report(sched_client_t *client, const msg_t *hdr, script_report_t *report) {
+    if (hdr->request != PROCESS_REQUEST_REPORT || hdr->time_ms != sizeof(script_report_t)) {
+        fprintf(stderr, "Invalid script report\n");
+        return -1;
+    }
+    return read_all(client->sockfd, report, sizeof(script_report_t));
+}
+
+void sched_client_close(sched_client_t *client) {
+    if (client->shm) shm_channel_detach(client->shm);
+    if (client->sockfd >= 0) close(client->sockfd);
+    client->shm = NULL;
+    client->sockfd = -1;
+}
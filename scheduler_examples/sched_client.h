@@ -0,0 +1,91 @@
+#ifndef SCHED_CLIENT_H
+#define SCHED_CLIENT_H
+
+#include "burst_queue.h"
+#include "msg.h"
+#include "shm_channel.h"
+
+// Define the connection of an application to the scheduler
+// Requests and replies go over the UNIX socket, or over a shared-memory channel
+// when the application opted in (the socket is then only used for the handshake
+// and to tell the scheduler that the application went away).
+typedef struct sched_client_st {
+    int sockfd;                 // Socket connected to SOCKET_PATH
+    shm_channel_t *shm;         // Shared-memory channel, or NULL for the socket transport
+    int version;                // Protocol version spoken on the socket (PROTOCOL_V1 or PROTOCOL_V2)
+    uint32_t seq;               // seq of the last v2 request
+    uint32_t skip_acks;         // ACKs to drop: requests sent with MSG_FLAG_NO_ACK over v1
+} sched_client_t;
+
+/**
+ * @brief Connect to the scheduler
+ *
+ * @param client The connection to initialize
+ * @param use_shm 1 to exchange messages through a shared-memory channel
+ * @return 0 on success, -1 on failure
+ */
+int sched_client_connect(sched_client_t *client, int use_shm);
+
+/**
+ * @brief Ask the scheduler for protocol v2 (socket transport only)
+ *
+ * Must be called right after sched_client_connect. If the scheduler only grants v1
+ * the connection keeps working on v1.
+ *
+ * @return The version granted, or -1 on failure
+ */
+int sched_client_hello(sched_client_t *client);
+
+/**
+ * @brief Send a request to the scheduler
+ *
+ * @return 0 on success, -1 on failure
+ */
+int sched_client_send(sched_client_t *client, const msg_t *msg);
+
+/**
+ * @brief Send a request to the scheduler with MSG_FLAG_* flags
+ *
+ * With MSG_FLAG_NO_ACK the next reply to this request is its DONE. On v1 the
+ * scheduler still sends the ACK, and sched_client_recv drops it.
+ *
+ * @return 0 on success, -1 on failure
+ */
+int sched_client_send_flags(sched_client_t *client, const msg_t *msg, uint16_t flags);
+
+/**
+ * @brief Wait for the next reply of the scheduler
+ *
+ * @return 0 on success, -1 on failure
+ */
+int sched_client_recv(sched_client_t *client, msg_t *msg);
+
+/**
+ * @brief Upload all the bursts of a queue as one burst script (socket transport only)
+ *
+ * The queue is left untouched. The scheduler answers with an ACK, one DONE per
+ * burst (unless SCRIPT_FLAG_FINAL_REPORT is set) and a PROCESS_REQUEST_REPORT frame.
+ *
+ * @param client The connection
+ * @param bursts The bursts to run, in order
+ * @param flags SCRIPT_FLAG_*
+ * @return 0 on success, -1 on failure (including a queue without bursts left)
+ */
+int sched_client_send_script(sched_client_t *client, const burst_queue_t *bursts, uint32_t flags);
+
+/**
+ * @brief Read the payload of a PROCESS_REQUEST_REPORT frame
+ *
+ * @param client The connection
+ * @param hdr The header of the frame, already received with sched_client_recv
+ * @param report Receives the report
+ * @return 0 on success, -1 on failure
+ */
+int sched_client_recv_report(sched_client_t *client, const msg_t *hdr, script_report_t *report);
+
+/**
+ * @brief Close the connection
+ */
+void sched_client_close(sched_client_t *client);
+
+#endif //SCHED_CLIENT_H
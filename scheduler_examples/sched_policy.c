@@ -0,0 +1,79 @@
+#include "sched_policy.h"
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fifo.h"
+#include "SJF.h"
+#include "RR.h"
+#include "MLFQ.h"
+
+static const sched_policy_t *BUILTIN_POLICIES[] = {
+    &fifo_policy,
+    &sjf_policy,
+    &rr_policy,
+    &mlfq_policy,
+    NULL
+};  // array de políticas incluídas no simulador
+
+static int is_plugin_path(const char *name) {
+    size_t len = strlen(name);
+    return strchr(name, '/') != NULL || (len > 3 && strcmp(name + len - 3, ".so") == 0);
+}
+
+static const sched_policy_t *load_plugin(scheduler_t *sched, const char *path) {
+    sched->plugin = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!sched->plugin) {
+        fprintf(stderr, "dlopen: %s\n", dlerror());
+        return NULL;
+    }
+    const sched_policy_t *policy = dlsym(sched->plugin, SCHED_POLICY_SYMBOL);
+    if (!policy || !policy->init || !policy->enqueue || !policy->pick_next || !policy->tick || !policy->destroy) {
+        fprintf(stderr, "%s does not export a valid %s\n", path, SCHED_POLICY_SYMBOL);
+        dlclose(sched->plugin);
+        sched->plugin = NULL;
+        return NULL;
+    }
+    return policy;
+}
+
+int scheduler_create(scheduler_t *sched, const char *name, const char *options) {
+    memset(sched, 0, sizeof(scheduler_t));
+    if (is_plugin_path(name)) {
+        sched->policy = load_plugin(sched, name);
+        if (!sched->policy) return -1;
+    } else {
+        for (int i = 0; BUILTIN_POLICIES[i] != NULL; i++) {
+            if (strcmp(name, BUILTIN_POLICIES[i]->name) == 0) {
+                sched->policy = BUILTIN_POLICIES[i];
+                break;
+            }
+        }
+        if (!sched->policy) {
+            printf("Scheduler %s not recognized. Available options are:\n", name);
+            for (int i = 0; BUILTIN_POLICIES[i] != NULL; i++) {
+                printf(" - %s\n", BUILTIN_POLICIES[i]->name);
+            }
+            printf(" - <path/to/policy.so>\n");
+            return -1;
+        }
+    }
+    sched->state = sched->policy->init(options);
+    if (!sched->state) {
+        fprintf(stderr, "Failed to create %s\n", sched->policy->name);
+        scheduler_destroy(sched);
+        return -1;
+    }
+    return 0;
+}
+
+void scheduler_destroy(scheduler_t *sched) {
+    if (sched->state) sched->policy->destroy(sched->state);
+    if (sched->plugin) dlclose(sched->plugin);
+    memset(sched, 0, sizeof(scheduler_t));
+}
+
+uint32_t sched_time_left(const pcb_t *pcb) {
+    return (pcb->ellapsed_time_ms < pcb->time_ms) ? pcb->time_ms - pcb->ellapsed_time_ms : 0;
+}
@@ -0,0 +1,107 @@
+#ifndef SCHED_POLICY_H
+#define SCHED_POLICY_H
+
+#include <stdint.h>
+
+#include "queue.h"
+
+// Result of accounting run time to the task on the CPU
+typedef enum {
+    SCHED_TICK_CONTINUE = 0,    // The task keeps the CPU
+    SCHED_TICK_DONE,            // The task used all the time it requested (the core sends DONE)
+    SCHED_TICK_PREEMPTED,       // The task was put back in the ready structure of the policy
+} sched_tick_en;
+
+// Define the interface of a scheduling policy
+// Every policy keeps its ready tasks in its own (opaque) state, so it can use
+// whatever index structure suits it. The simulator core only hands it new
+// arrivals, accounts run time through tick() and asks it for the next task.
+typedef struct sched_policy_st {
+    const char *name;
+
+    /**
+     * @brief Create the state of the policy
+     *
+     * @param options Policy specific options (key=value,...), or NULL for the defaults
+     * @return The state passed to the other callbacks, or NULL on failure
+     */
+    void *(*init)(const char *options);
+
+    /**
+     * @brief Add a task that just requested the CPU (RUN) to the ready tasks
+     *
+     * @return 1 if the task was added, 0 on failure (the policy does not keep the task)
+     */
+    int (*enqueue)(void *state, pcb_t *pcb, uint32_t current_time_ms);
+
+    /**
+     * @brief Remove and return the task that should run next
+     *
+     * @return The next task, or NULL if there are no ready tasks
+     */
+    pcb_t *(*pick_next)(void *state, uint32_t current_time_ms);
+
+    /**
+     * @brief Account elapsed_ms of run time to the task on the CPU
+     *
+     * elapsed_ms is TICKS_MS in the regular loop, but can be larger when the
+     * simulator skips ticks in which nothing happens (see run_time_left).
+     * When the task is preempted the policy puts it back in its ready tasks
+     * before returning SCHED_TICK_PREEMPTED.
+     */
+    sched_tick_en (*tick)(void *state, pcb_t *running, uint32_t current_time_ms, uint32_t elapsed_ms);
+
+    /**
+     * @brief Run time the task on the CPU has left before tick() stops it
+     *
+     * @return Milliseconds until tick() returns DONE or PREEMPTED
+     */
+    uint32_t (*run_time_left)(void *state, const pcb_t *running);
+
+    /**
+     * @brief Release the state of the policy (the pcbs it still holds are not freed)
+     */
+    void (*destroy)(void *state);
+} sched_policy_t;
+
+// An instance of a policy: the callbacks and their state
+typedef struct scheduler_st {
+    const sched_policy_t *policy;
+    void *state;
+    void *plugin;               // dlopen() handle when the policy was loaded from a plugin
+} scheduler_t;
+
+// Name of the symbol (a const sched_policy_t) that a policy plugin must export
+#define SCHED_POLICY_SYMBOL "sched_policy"
+
+/**
+ * @brief Create a scheduler instance
+ *
+ * The name is either a built-in policy (FIFO, SJF, RR, MLFQ) or the path of a
+ * shared object (containing a '/' or ending in ".so") that exports a
+ * sched_policy_t named SCHED_POLICY_SYMBOL.
+ *
+ * @param sched The instance to initialize
+ * @param name Name of a built-in policy or path to a policy plugin
+ * @param options Policy specific options, or NULL
+ * @return 0 on success, -1 on failure
+ */
+int scheduler_create(scheduler_t *sched, const char *name, const char *options);
+
+/**
+ * @brief Destroy a scheduler instance (and unload its plugin)
+ *
+ * @param sched The instance to destroy
+ */
+void scheduler_destroy(scheduler_t *sched);
+
+/**
+ * @brief Run time left for a task under the FIFO rule (no preemption)
+ *
+ * Helper for policies without time slices.
+ *
+ * @return Milliseconds of run time the task still requested
+ */
+uint32_t sched_time_left(const pcb_t *pcb);
+
+#endif //SCHED_POLICY_H
@@ -0,0 +1,46 @@
+#include "script.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+script_t *script_parse(const void *payload, uint32_t len) {
+    const unsigned char *p = payload;
+    const unsigned char *end = p + len;
+    script_header_t header;
+    if (len < sizeof(header)) return NULL;
+    memcpy(&header, p, sizeof(header));
+    p += sizeof(header);
+    // Every burst takes at least a script_burst_t, so count is bounded by the payload
+    if (header.count == 0 || header.count > (len - sizeof(header)) / sizeof(script_burst_t)) return NULL;
+
+    script_t *script = calloc(1, sizeof(script_t));
+    if (!script) return NULL;
+    script->steps = malloc(header.count * sizeof(script_step_t));
+    if (!script->steps) {
+        script_free(script);
+        return NULL;
+    }
+    for (uint32_t i = 0; i < header.count; i++) {
+        script_burst_t burst;
+        if ((size_t) (end - p) < sizeof(burst)) break;
+        memcpy(&burst, p, sizeof(burst));
+        p += sizeof(burst);
+        if (burst.page_count > MAX_PAGES || (size_t) (end - p) < burst.page_count * sizeof(uint32_t)) break;
+        p += burst.page_count * sizeof(uint32_t);     // as páginas ainda não são usadas pelo simulador
+        script->steps[script->count].burst_time_ms = burst.burst_time_ms;
+        script->steps[script->count].block_time_ms = burst.block_time_ms;
+        script->count++;
+    }
+    if (script->count != header.count || p != end) {    // truncado ou com bytes a mais
+        script_free(script);
+        return NULL;
+    }
+    script->flags = header.flags;
+    return script;
+}
+
+void script_free(script_t *script) {
+    if (!script) return;
+    free(script->steps);
+    free(script);
+}
@@ -0,0 +1,38 @@
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+#include <stdint.h>
+
+#include "msg.h"
+
+// One burst of a script, as the scheduler runs it
+typedef struct {
+    uint32_t burst_time_ms;         // CPU time of the burst
+    uint32_t block_time_ms;         // Block time after the burst (0 for none)
+} script_step_t;
+
+// Define a burst script that the scheduler runs on behalf of an application
+typedef struct script_st {
+    script_step_t *steps;           // The bursts, in order
+    uint32_t count;                 // Number of bursts
+    uint32_t next;                  // Burst being run
+    uint32_t flags;                 // SCRIPT_FLAG_*
+    int blocked;                    // The current burst finished its CPU time and is blocked
+    script_report_t report;         // Statistics sent in the final report
+} script_t;
+
+/**
+ * @brief Parse the payload of a PROCESS_REQUEST_SCRIPT frame
+ *
+ * @param payload The bytes that follow the msg_t header
+ * @param len Number of bytes in payload
+ * @return The script, or NULL if the payload is malformed
+ */
+script_t *script_parse(const void *payload, uint32_t len);
+
+/**
+ * @brief Release a script
+ */
+void script_free(script_t *script);
+
+#endif //SCRIPT_H
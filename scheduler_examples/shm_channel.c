@@ -0,0 +1,145 @@
+#define _GNU_SOURCE     // memfd_create()
+
+#include "shm_channel.h"
+
+#include <errno.h>
+#include <linux/futex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define SPIN_BEFORE_SLEEP 2000  // polls of the reply ring before sleeping on the futex
+
+static uint32_t align_up(uint32_t x) {
+    return (x + RING_CACHE_LINE - 1) & ~(uint32_t) (RING_CACHE_LINE - 1);
+}
+
+static uint32_t ring_bytes(void) {
+    return align_up((uint32_t) spsc_ring_bytes(SHM_CHANNEL_SLOTS, sizeof(msg_t)));
+}
+
+static spsc_ring_t *request_ring(shm_channel_t *ch) {
+    return (spsc_ring_t *) ((unsigned char *) ch + ch->request_offset);
+}
+
+static spsc_ring_t *reply_ring(shm_channel_t *ch) {
+    return (spsc_ring_t *) ((unsigned char *) ch + ch->reply_offset);
+}
+
+uint32_t shm_channel_bytes(void) {
+    return align_up(sizeof(shm_channel_t)) + 2 * ring_bytes();
+}
+
+shm_channel_t *shm_channel_create(int *fd) {
+    uint32_t size = shm_channel_bytes();
+    *fd = memfd_create("ossim-channel", MFD_CLOEXEC);
+    if (*fd < 0) {
+        perror("memfd_create");
+        return NULL;
+    }
+    if (ftruncate(*fd, size) < 0) {
+        perror("ftruncate");
+        close(*fd);
+        return NULL;
+    }
+    shm_channel_t *ch = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0);
+    if (ch == MAP_FAILED) {
+        perror("mmap");
+        close(*fd);
+        return NULL;
+    }
+    ch->size = size;
+    ch->request_offset = align_up(sizeof(shm_channel_t));
+    ch->reply_offset = ch->request_offset + ring_bytes();
+    atomic_init(&ch->reply_seq, 0);
+    atomic_init(&ch->client_waiting, 0);
+    spsc_ring_init(request_ring(ch), SHM_CHANNEL_SLOTS, sizeof(msg_t));
+    spsc_ring_init(reply_ring(ch), SHM_CHANNEL_SLOTS, sizeof(msg_t));
+    ch->magic = SHM_CHANNEL_MAGIC;
+    return ch;
+}
+
+shm_endpoint_t *shm_channel_attach(int fd) {
+    struct stat st;
+    uint32_t size = shm_channel_bytes();
+    if (fstat(fd, &st) < 0 || st.st_size != (off_t) size) {
+        fprintf(stderr, "Shared-memory channel has the wrong size\n");
+        return NULL;
+    }
+    shm_endpoint_t *ep = malloc(sizeof(shm_endpoint_t));
+    if (!ep) {
+        perror("malloc");
+        return NULL;
+    }
+    shm_channel_t *ch = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ch == MAP_FAILED) {
+        perror("mmap");
+        free(ep);
+        return NULL;
+    }
+    // The application owns the layout: only accept the one this scheduler would build.
+    // The offsets are read once here; the rings are then used with our own layout.
+    uint32_t request_offset = ch->request_offset;
+    uint32_t reply_offset = ch->reply_offset;
+    if (ch->magic != SHM_CHANNEL_MAGIC || ch->size != size ||
+        request_offset != align_up(sizeof(shm_channel_t)) || reply_offset != request_offset + ring_bytes()) {
+        fprintf(stderr, "Invalid shared-memory channel\n");
+        munmap(ch, size);
+        free(ep);
+        return NULL;
+    }
+    ep->ch = ch;
+    ep->requests = (spsc_ring_t *) ((unsigned char *) ch + request_offset);
+    ep->replies = (spsc_ring_t *) ((unsigned char *) ch + reply_offset);
+    return ep;
+}
+
+void shm_channel_detach(shm_channel_t *ch) {
+    munmap(ch, shm_channel_bytes());
+}
+
+void shm_channel_release(shm_endpoint_t *ep) {
+    shm_channel_detach(ep->ch);
+    free(ep);
+}
+
+int shm_channel_send_request(shm_channel_t *ch, const msg_t *msg) {
+    return spsc_ring_push(request_ring(ch), msg);
+}
+
+int shm_channel_poll_request(shm_endpoint_t *ep, msg_t *msg) {
+    return spsc_ring_pop_sized(ep->requests, msg, SHM_CHANNEL_SLOTS, sizeof(msg_t));
+}
+
+int shm_channel_send_reply(shm_endpoint_t *ep, const msg_t *msg) {
+    shm_channel_t *ch = ep->ch;
+    if (!spsc_ring_push_sized(ep->replies, msg, SHM_CHANNEL_SLOTS, sizeof(msg_t))) return 0;
+    atomic_fetch_add(&ch->reply_seq, 1);
+    if (atomic_load(&ch->client_waiting)) {     // só acorda a aplicação se estiver a dormir
+        syscall(SYS_futex, &ch->reply_seq, FUTEX_WAKE, 1, NULL, NULL, 0);
+    }
+    return 1;
+}
+
+void shm_channel_wait_reply(shm_channel_t *ch, msg_t *msg) {
+    for (;;) {
+        for (int i = 0; i < SPIN_BEFORE_SLEEP; i++) {
+            if (spsc_ring_pop(reply_ring(ch), msg)) return;
+        }
+        uint32_t seq = atomic_load(&ch->reply_seq);
+        atomic_store(&ch->client_waiting, 1);
+        // Check again after announcing the sleep, so a reply sent in between is not missed
+        if (spsc_ring_pop(reply_ring(ch), msg)) {
+            atomic_store(&ch->client_waiting, 0);
+            return;
+        }
+        // Returns at once (EAGAIN) if a reply was sent after reading seq
+        if (syscall(SYS_futex, &ch->reply_seq, FUTEX_WAIT, seq, NULL, NULL, 0) < 0 && errno != EAGAIN && errno != EINTR) {
+            perror("futex");
+        }
+        atomic_store(&ch->client_waiting, 0);
+    }
+}
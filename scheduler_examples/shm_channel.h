@@ -0,0 +1,100 @@
+#ifndef SHM_CHANNEL_H
+#define SHM_CHANNEL_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "msg.h"
+#include "ring.h"
+
+#define SHM_CHANNEL_MAGIC 0x4f53534d    // "OSSM"
+#define SHM_CHANNEL_SLOTS 16            // msg_t slots in each direction
+
+// Define a shared-memory channel between one application and the scheduler
+// The application creates it in a memfd and passes the fd to the scheduler over the
+// socket (SCM_RIGHTS with a PROCESS_REQUEST_SHM message). After that handshake every
+// request and reply goes through the two SPSC rings of the mapping, with no syscall.
+// The scheduler polls the request ring of applications that owe it a request. An
+// application waiting for a reply sleeps on a futex on reply_seq, and the scheduler
+// only calls futex wake when client_waiting says it is asleep.
+typedef struct shm_channel_st {
+    uint32_t magic;                                     // SHM_CHANNEL_MAGIC
+    uint32_t size;                                      // Size of the mapping in bytes
+    uint32_t request_offset;                            // Offset of the request ring (application -> scheduler)
+    uint32_t reply_offset;                              // Offset of the reply ring (scheduler -> application)
+    _Alignas(RING_CACHE_LINE) _Atomic uint32_t reply_seq;   // Futex word, incremented on every reply
+    _Atomic uint32_t client_waiting;                    // The application sleeps on reply_seq
+} shm_channel_t;
+
+// Define the scheduler side of a channel
+// The application can rewrite the mapping at any time, so the layout checked once by
+// shm_channel_attach is kept here and the ring headers in the mapping are never read.
+typedef struct shm_endpoint_st {
+    shm_channel_t *ch;                                  // The mapping
+    spsc_ring_t *requests;                              // Request ring, at the validated offset
+    spsc_ring_t *replies;                               // Reply ring, at the validated offset
+} shm_endpoint_t;
+
+/**
+ * @brief Size of a channel mapping
+ */
+uint32_t shm_channel_bytes(void);
+
+/**
+ * @brief Create a channel in a new memfd (application side)
+ *
+ * @param fd Receives the memfd, to be passed to the scheduler
+ * @return The mapped channel, or NULL on failure
+ */
+shm_channel_t *shm_channel_create(int *fd);
+
+/**
+ * @brief Map a channel received from an application (scheduler side)
+ *
+ * @param fd The memfd received over the socket (not closed by this function)
+ * @return The endpoint of the mapped channel (release with shm_channel_release),
+ *         or NULL if the fd does not hold a valid channel
+ */
+shm_endpoint_t *shm_channel_attach(int fd);
+
+/**
+ * @brief Unmap a channel (application side)
+ */
+void shm_channel_detach(shm_channel_t *ch);
+
+/**
+ * @brief Unmap a channel and free its endpoint (scheduler side)
+ */
+void shm_channel_release(shm_endpoint_t *ep);
+
+/**
+ * @brief Send a request to the scheduler (application side)
+ *
+ * @return 1 on success, 0 if the request ring is full
+ */
+int shm_channel_send_request(shm_channel_t *ch, const msg_t *msg);
+
+/**
+ * @brief Take the next request of the application, without blocking (scheduler side)
+ *
+ * @return 1 if a request was taken, 0 if there are none
+ */
+int shm_channel_poll_request(shm_endpoint_t *ep, msg_t *msg);
+
+/**
+ * @brief Send a reply to the application and wake it up if it sleeps (scheduler side)
+ *
+ * @return 1 on success, 0 if the reply ring is full
+ */
+int shm_channel_send_reply(shm_endpoint_t *ep, const msg_t *msg);
+
+/**
+ * @brief Wait for the next reply of the scheduler (application side)
+ *
+ * Spins for a short while and then sleeps on the futex until a reply arrives.
+ *
+ * @param msg Receives the reply
+ */
+void shm_channel_wait_reply(shm_channel_t *ch, msg_t *msg);
+
+#endif //SHM_CHANNEL_H
@@ -0,0 +1,40 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "burst_queue.h"
+#include "workload.h"
+
+/*
+ * Round trip of the page encoding through a binary workload: a burst whose pages
+ * span the whole 32-bit range must decode back unchanged.
+ *
+ * Run with ctest, or like: ./test_workload
+ */
+
+// Pages whose differences need all 33 bits: far apart, both ways, around INT_MAX
+static const uint32_t PAGES[] = {
+    0, UINT32_MAX, 0, (uint32_t) INT_MAX + 1, INT_MAX, 2666750965u, 7, UINT32_MAX - 1, 1
+};
+
+int main(void) {
+    burst_queue_t q = {0};
+    burst_t burst = {.burst_time_ms = 10, .block_time_ms = 20, .nice = -3};
+    size_t npages = sizeof(PAGES) / sizeof(PAGES[0]);
+    for (size_t i = 0; i < npages; i++) burst.pages.ids[i] = PAGES[i];
+    burst.pages.count = (uint32_t) npages;
+    void *image = NULL;
+    size_t size;
+    int ok = enqueue_burst(&q, &burst) && workload_image(&q, &image, &size) == 0;
+    const workload_header_t *hdr = ok ? workload_check(image, size) : NULL;
+    burst_t decoded;
+    ok = hdr != NULL && hdr->count == 1 && workload_decode(hdr, 0, &decoded) == 0 &&
+         decoded.burst_time_ms == burst.burst_time_ms && decoded.block_time_ms == burst.block_time_ms &&
+         decoded.nice == burst.nice && decoded.pages.count == burst.pages.count &&
+         memcmp(decoded.pages.ids, burst.pages.ids, npages * sizeof(uint32_t)) == 0;
+    free(image);
+    free_burst_queue(&q);
+    printf("Round trip of %zu pages through a binary workload: %s\n", npages, ok ? "OK" : "FAILED");
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,101 @@
+#include "tick_clock.h"
+
+#include <errno.h>
+
+#define NS_PER_S  1000000000LL
+#define NS_PER_MS 1000000LL
+
+static int64_t ts_ns(const struct timespec *ts) {
+    return (int64_t) ts->tv_sec * NS_PER_S + ts->tv_nsec;
+}
+
+static struct timespec ns_ts(int64_t ns) {
+    struct timespec ts = {.tv_sec = (time_t) (ns / NS_PER_S), .tv_nsec = (long) (ns % NS_PER_S)};
+    return ts;
+}
+
+static int64_t now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ts_ns(&now);
+}
+
+// Bucket of a duration: the number of bits of its value in microseconds
+static int bucket(uint64_t ns) {
+    uint64_t us = ns / 1000;
+    int b = 0;
+    while (us > 0 && b < TICK_CLOCK_BUCKETS - 1) {
+        us >>= 1;
+        b++;
+    }
+    return b;
+}
+
+void tick_clock_init(tick_clock_t *clk) {
+    *clk = (tick_clock_t) {0};
+    clock_gettime(CLOCK_MONOTONIC, &clk->base);
+    clk->busy_since = clk->base;
+}
+
+uint32_t tick_clock_now_ms(const tick_clock_t *clk) {
+    return (uint32_t) ((now_ns() - ts_ns(&clk->base)) / NS_PER_MS);
+}
+
+void tick_clock_deadline(const tick_clock_t *clk, uint32_t sim_ms, struct timespec *ts) {
+    *ts = ns_ts(ts_ns(&clk->base) + (int64_t) sim_ms * NS_PER_MS);
+}
+
+void tick_clock_wait(tick_clock_t *clk, uint32_t sim_ms, int end_of_tick) {
+    int64_t now = now_ns();
+    clk->busy_ns += (uint64_t) (now - ts_ns(&clk->busy_since));
+
+    struct timespec deadline;
+    tick_clock_deadline(clk, sim_ms, &deadline);
+    int overrun = (now >= ts_ns(&deadline));    // o trabalho já passou do prazo
+    if (!overrun) {
+        int err = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+        if (err != 0 && err != EINTR) perror("clock_nanosleep");
+    }
+    int64_t woke = now_ns();
+    clk->busy_since = ns_ts(woke);
+    if (!end_of_tick) return;
+
+    uint64_t lateness = (woke > ts_ns(&deadline)) ? (uint64_t) (woke - ts_ns(&deadline)) : 0;
+    clk->ticks++;
+    clk->overruns += overrun;
+    clk->lateness_hist[bucket(lateness)]++;
+    clk->work_hist[bucket(clk->busy_ns)]++;
+    if (lateness > clk->max_lateness_ns) clk->max_lateness_ns = lateness;
+    if (clk->busy_ns > clk->max_work_ns) clk->max_work_ns = clk->busy_ns;
+    clk->busy_ns = 0;
+}
+
+void tick_clock_skip(tick_clock_t *clk, uint32_t ms) {
+    clk->base = ns_ts(ts_ns(&clk->base) - (int64_t) ms * NS_PER_MS);
+}
+
+void tick_clock_resume(tick_clock_t *clk) {
+    clock_gettime(CLOCK_MONOTONIC, &clk->busy_since);
+}
+
+static void print_hist(FILE *out, const char *name, const uint64_t *hist) {
+    fprintf(out, "%s:", name);
+    for (int b = 0; b < TICK_CLOCK_BUCKETS; b++) {
+        if (hist[b] == 0) continue;
+        if (b == TICK_CLOCK_BUCKETS - 1) {
+            fprintf(out, " >=%lluus: %llu", 1ULL << (b - 1), (unsigned long long) hist[b]);
+        } else {
+            fprintf(out, " <%lluus: %llu", 1ULL << b, (unsigned long long) hist[b]);
+        }
+    }
+    fprintf(out, "\n");
+}
+
+void tick_clock_print_stats(const tick_clock_t *clk, FILE *out) {
+    if (clk->ticks == 0) return;
+    fprintf(out, "Ticks: %llu, overruns: %llu, max lateness %.3f ms, max work %.3f ms\n",
+            (unsigned long long) clk->ticks, (unsigned long long) clk->overruns,
+            (double) clk->max_lateness_ns / NS_PER_MS, (double) clk->max_work_ns / NS_PER_MS);
+    print_hist(out, "Tick lateness", clk->lateness_hist);
+    print_hist(out, "Tick work time", clk->work_hist);
+}
@@ -0,0 +1,89 @@
+#ifndef TICK_CLOCK_H
+#define TICK_CLOCK_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+// Histogram buckets: bucket 0 counts values under 1 us, bucket b values in
+// [2^(b-1), 2^b) us, and the last bucket everything from 2^(TICK_CLOCK_BUCKETS-2) us up.
+#define TICK_CLOCK_BUCKETS 24
+
+// Define the real-time clock that paces the ticks of the simulator
+// Every wait sleeps until an absolute instant, base + the simulated time of the
+// point reached, so the time spent on scheduling work never accumulates as drift.
+// Each tick records how late the simulator woke up for it and how long its work
+// took. A tick overruns when its work was still going on at the deadline of the
+// next wait, i.e. the simulator could not keep up.
+typedef struct tick_clock_st {
+    struct timespec base;                       // Real time of simulated time 0
+    struct timespec busy_since;                 // End of the last wait
+    uint64_t busy_ns;                           // Work time of the current tick so far
+    uint64_t ticks;                             // Ticks measured
+    uint64_t overruns;                          // Ticks whose work ran past a deadline
+    uint64_t max_lateness_ns;                   // Latest wake-up
+    uint64_t max_work_ns;                       // Longest work time of a tick
+    uint64_t lateness_hist[TICK_CLOCK_BUCKETS]; // Ticks by wake-up lateness
+    uint64_t work_hist[TICK_CLOCK_BUCKETS];     // Ticks by work time
+} tick_clock_t;
+
+/**
+ * @brief Start the clock: simulated time 0 is now
+ *
+ * @param clk The clock to initialize
+ */
+void tick_clock_init(tick_clock_t *clk);
+
+/**
+ * @brief Simulated time (in ms) the real clock has reached
+ */
+uint32_t tick_clock_now_ms(const tick_clock_t *clk);
+
+/**
+ * @brief Real (CLOCK_MONOTONIC) instant of a simulated time
+ *
+ * @param clk The clock
+ * @param sim_ms The simulated time in milliseconds
+ * @param ts Receives the absolute instant
+ */
+void tick_clock_deadline(const tick_clock_t *clk, uint32_t sim_ms, struct timespec *ts);
+
+/**
+ * @brief Sleep until the real instant of a simulated time (clock_nanosleep with TIMER_ABSTIME)
+ *
+ * Returns at once if that instant already passed. A signal may end the sleep early.
+ *
+ * @param clk The clock
+ * @param sim_ms The simulated time to wait for
+ * @param end_of_tick 1 if the wait ends a tick: its lateness and work time are recorded
+ */
+void tick_clock_wait(tick_clock_t *clk, uint32_t sim_ms, int end_of_tick);
+
+/**
+ * @brief Move the clock forward without waiting (virtual time)
+ *
+ * The next waits are shifted by ms, as if that much real time had already passed.
+ *
+ * @param clk The clock
+ * @param ms Simulated time skipped, in milliseconds
+ */
+void tick_clock_skip(tick_clock_t *clk, uint32_t ms);
+
+/**
+ * @brief Tell the clock that the simulator slept outside of tick_clock_wait (e.g. while idle)
+ *
+ * The time since the last wait is not counted as work of the current tick.
+ *
+ * @param clk The clock
+ */
+void tick_clock_resume(tick_clock_t *clk);
+
+/**
+ * @brief Print the overrun counter and the lateness and work time histograms
+ *
+ * @param clk The clock
+ * @param out The stream to print to
+ */
+void tick_clock_print_stats(const tick_clock_t *clk, FILE *out);
+
+#endif //TICK_CLOCK_H
@@ -0,0 +1,131 @@
+#include "timer_wheel.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "msg.h"
+
+void timer_wheel_init(timer_wheel_t *tw) {
+    memset(tw, 0, sizeof(timer_wheel_t));
+}
+
+uint32_t timer_wheel_time_ms(const timer_wheel_t *tw) {
+    return (tw->now_tick > 0) ? (tw->now_tick - 1) * TICKS_MS : 0;
+}
+
+// Pick the bucket for a tick, relative to the current position of the wheel
+static queue_t *wheel_bucket(timer_wheel_t *tw, uint32_t tick) {
+    uint32_t delta = tick - tw->now_tick;
+    for (int level = 0; level < WHEEL_LEVELS - 1; level++) {
+        if (delta < (1u << ((level + 1) * WHEEL_BITS))) {
+            return &tw->slots[level][(tick >> (level * WHEEL_BITS)) & WHEEL_MASK];
+        }
+    }
+    // Too far away: park it in the last level, it is cascaded again when its slot comes up
+    const int level = WHEEL_LEVELS - 1;
+    if (delta >= (1u << ((level + 1) * WHEEL_BITS))) {
+        tick = tw->now_tick + (1u << ((level + 1) * WHEEL_BITS)) - 1;
+    }
+    return &tw->slots[level][(tick >> (level * WHEEL_BITS)) & WHEEL_MASK];
+}
+
+static uint32_t wake_tick(uint32_t wake_time_ms) {
+    return (wake_time_ms + TICKS_MS - 1) / TICKS_MS;
+}
+
+static int wheel_insert(timer_wheel_t *tw, pcb_t *pcb) {
+    uint32_t tick = wake_tick(pcb->wake_time_ms);
+    if ((int32_t)(tick - tw->now_tick) < 0) {
+        tick = tw->now_tick;    // already due, expire in the next processed tick
+    }
+    return enqueue_pcb(wheel_bucket(tw, tick), pcb);
+}
+
+int timer_wheel_add(timer_wheel_t *tw, pcb_t *pcb, uint32_t wake_time_ms) {
+    pcb->wake_time_ms = wake_time_ms;
+    if (!wheel_insert(tw, pcb)) return 0;
+    tw->count++;
+    return 1;
+}
+
+// Move all pcbs of the current slot of a level down to the lower levels
+static void cascade(timer_wheel_t *tw, int level) {
+    queue_t *bucket = &tw->slots[level][(tw->now_tick >> (level * WHEEL_BITS)) & WHEEL_MASK];
+    queue_t pending = *bucket;
+    bucket->head = bucket->tail = PCB_HANDLE_NONE;
+    pcb_t *pcb;
+    while ((pcb = dequeue_pcb(&pending)) != NULL) {
+        wheel_insert(tw, pcb);
+    }
+}
+
+uint32_t timer_wheel_advance(timer_wheel_t *tw, uint32_t current_time_ms, queue_t *expired) {
+    uint32_t last_tick = current_time_ms / TICKS_MS;
+    uint32_t n = 0;
+    if (tw->count == 0) {
+        // Nothing to expire, just move the wheel forward
+        if ((int32_t)(last_tick - tw->now_tick) >= 0) tw->now_tick = last_tick + 1;
+        return 0;
+    }
+    while ((int32_t)(last_tick - tw->now_tick) >= 0) {
+        uint32_t idx = tw->now_tick & WHEEL_MASK;
+        if (idx == 0) {
+            // Level 0 wrapped around: refill it from the next level (and so on upwards)
+            for (int level = 1; level < WHEEL_LEVELS; level++) {
+                cascade(tw, level);
+                if (((tw->now_tick >> (level * WHEEL_BITS)) & WHEEL_MASK) != 0) break;
+            }
+        }
+        queue_t *bucket = &tw->slots[0][idx];
+        pcb_t *pcb;
+        while ((pcb = dequeue_pcb(bucket)) != NULL) {
+            enqueue_pcb(expired, pcb);
+            n++;
+        }
+        tw->now_tick++;
+        if (tw->count == n) {
+            // Wheel is now empty, no need to visit the remaining buckets one by one
+            if ((int32_t)(last_tick - tw->now_tick) >= 0) tw->now_tick = last_tick + 1;
+            break;
+        }
+    }
+    tw->count -= n;
+    return n;
+}
+
+int timer_wheel_next_expiry(const timer_wheel_t *tw, uint32_t *wake_time_ms) {
+    if (tw->count == 0) return 0;
+    uint32_t best = 0;
+    int found = 0;
+    // Level 0 buckets hold exactly one tick each, the first non-empty one is its earliest
+    for (uint32_t i = 0; i < WHEEL_SLOTS; i++) {
+        uint32_t tick = tw->now_tick + i;
+        if (!queue_empty(&tw->slots[0][tick & WHEEL_MASK])) {
+            best = tick;
+            found = 1;
+            break;
+        }
+    }
+    // Higher levels may still hold earlier timers that are not cascaded yet:
+    // the earliest of each level is in its first non-empty bucket
+    for (int level = 1; level < WHEEL_LEVELS; level++) {
+        uint32_t base = tw->now_tick >> (level * WHEEL_BITS);
+        // The current slot is only cascaded once the lower levels wrap around
+        uint32_t first = (tw->now_tick & ((1u << (level * WHEEL_BITS)) - 1)) == 0 ? 0 : 1;
+        for (uint32_t i = first; i < first + WHEEL_SLOTS; i++) {
+            const queue_t *bucket = &tw->slots[level][(base + i) & WHEEL_MASK];
+            if (queue_empty(bucket)) continue;
+            for (const pcb_t *pcb = queue_head(bucket); pcb != NULL; pcb = queue_next(pcb)) {
+                uint32_t tick = wake_tick(pcb->wake_time_ms);
+                if (!found || (int32_t)(tick - best) < 0) {
+                    best = tick;
+                    found = 1;
+                }
+            }
+            break;
+        }
+    }
+    if ((int32_t)(best - tw->now_tick) < 0) best = tw->now_tick;
+    *wake_time_ms = best * TICKS_MS;
+    return found;
+}
@@ -0,0 +1,78 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <stdint.h>
+
+#include "queue.h"
+
+// Each level of the wheel has 2^WHEEL_BITS slots. A slot of level 0 spans one tick,
+// a slot of level n spans 2^(n*WHEEL_BITS) ticks. With 4 levels of 64 slots the wheel
+// covers 2^24 ticks (about 46 hours of simulated time with 10 ms ticks); longer timers
+// are parked in the last level and cascaded again until they are close enough.
+#define WHEEL_BITS   6
+#define WHEEL_SLOTS  (1u << WHEEL_BITS)
+#define WHEEL_MASK   (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS 4
+
+// Define the hierarchical timing wheel used for the blocked pcbs
+typedef struct timer_wheel_st {
+    queue_t slots[WHEEL_LEVELS][WHEEL_SLOTS];
+    uint32_t now_tick;      // Next tick to be processed (all earlier ticks have expired)
+    uint32_t count;         // Number of pcbs in the wheel
+} timer_wheel_t;
+
+/**
+ * @brief Initialize an empty timing wheel
+ *
+ * @param tw The timing wheel to initialize
+ */
+void timer_wheel_init(timer_wheel_t *tw);
+
+/**
+ * @brief Time of the last tick processed by the wheel
+ *
+ * Block times are counted from this instant: a pcb blocked for time_ms
+ * wakes up at timer_wheel_time_ms() + time_ms, rounded up to a tick.
+ *
+ * @param tw The timing wheel
+ * @return The time of the last processed tick in milliseconds (0 before the first one)
+ */
+uint32_t timer_wheel_time_ms(const timer_wheel_t *tw);
+
+/**
+ * @brief Add a pcb to the timing wheel
+ *
+ * The pcb is placed in the bucket of the tick in which it wakes up. Wake-up
+ * times in the past expire in the next tick that is processed.
+ *
+ * @param tw The timing wheel
+ * @param pcb The pcb to be added (its wake_time_ms field is updated)
+ * @param wake_time_ms Absolute wake-up time in milliseconds
+ * @return The number of pcb added (0 on failure)
+ */
+int timer_wheel_add(timer_wheel_t *tw, pcb_t *pcb, uint32_t wake_time_ms);
+
+/**
+ * @brief Advance the wheel up to (and including) the tick of current_time_ms
+ *
+ * Every pcb whose wake-up time falls in one of the processed ticks is appended
+ * to the expired queue, in wake-up order. Only the buckets of the processed
+ * ticks are touched (plus the occasional cascade of a higher level bucket).
+ *
+ * @param tw The timing wheel
+ * @param current_time_ms The current time in milliseconds
+ * @param expired The queue to which the expired pcbs are appended
+ * @return The number of expired pcbs
+ */
+uint32_t timer_wheel_advance(timer_wheel_t *tw, uint32_t current_time_ms, queue_t *expired);
+
+/**
+ * @brief Find the earliest wake-up time in the wheel
+ *
+ * @param tw The timing wheel
+ * @param wake_time_ms Set to the earliest wake-up time (rounded up to a tick)
+ * @return 1 if the wheel holds at least one pcb, 0 if it is empty
+ */
+int timer_wheel_next_expiry(const timer_wheel_t *tw, uint32_t *wake_time_ms);
+
+#endif //TIMER_WHEEL_H
@@ -0,0 +1,39 @@
+#include "util.h"
+
+#include <stdio.h>
+#include <sys/resource.h>
+#include <time.h>
+
+uint64_t rng_next(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+double rng_uniform01(uint64_t *state) {
+    return (double) (rng_next(state) >> 11) * 0x1.0p-53;     // 53 bits da mantissa
+}
+
+double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+uint64_t raise_fd_limit(uint64_t wanted) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) < 0) {
+        perror("getrlimit");
+        return 0;
+    }
+    if (rl.rlim_cur != RLIM_INFINITY && rl.rlim_cur < wanted) {
+        rlim_t old = rl.rlim_cur;
+        rl.rlim_cur = (rl.rlim_max == RLIM_INFINITY || rl.rlim_max >= wanted) ? (rlim_t) wanted : rl.rlim_max;
+        if (setrlimit(RLIMIT_NOFILE, &rl) < 0) {
+            perror("setrlimit");
+            rl.rlim_cur = old;
+        }
+    }
+    return (rl.rlim_cur == RLIM_INFINITY) ? UINT64_MAX : (uint64_t) rl.rlim_cur;
+}
@@ -0,0 +1,42 @@
+#ifndef UTIL_H
+#define UTIL_H
+
+#include <stdint.h>
+
+/*
+ * Small helpers shared by the simulator and its tools.
+ */
+
+/**
+ * @brief Next value of a splitmix64 generator
+ *
+ * Small, fast and good enough to draw burst times and arrivals. Any 64-bit value is
+ * a valid state, and the same seed always gives the same sequence.
+ *
+ * @param state The state of the generator, advanced by one step
+ * @return A uniform 64-bit value
+ */
+uint64_t rng_next(uint64_t *state);
+
+/**
+ * @brief Uniform double in [0, 1) from a splitmix64 generator
+ *
+ * @param state The state of the generator, advanced by one step
+ */
+double rng_uniform01(uint64_t *state);
+
+/**
+ * @brief Monotonic time in seconds, for measuring intervals
+ */
+double now_s(void);
+
+/**
+ * @brief Raise the soft limit of open files, up to the hard limit at most
+ *
+ * @param wanted Number of file descriptors needed
+ * @return The soft limit in place afterwards (it may be below wanted), or 0 if it
+ *         could not be read
+ */
+uint64_t raise_fd_limit(uint64_t wanted);
+
+#endif //UTIL_H
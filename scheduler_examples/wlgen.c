@@ -0,0 +1,368 @@
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "burst_queue.h"
+#include "util.h"
+#include "workload.h"
+
+/*
+ * Generates synthetic workloads for scale testing: one burst file per process
+ * (CSV or binary) in a directory, or all the processes in one workload trace.
+ * The processes are generated in parallel, and each one draws its bursts from
+ * its own generator seeded from --seed and its index, so the output is the same
+ * whatever the number of threads.
+ *
+ * Run like: ./wlgen --procs 1000 --bursts 100 --io-ratio 0.7 --dist pareto out/
+ *           ./wlgen --procs 1000 --trace out.bwlt
+ */
+
+// Pages of all processes: the burst file parser accepts page ids up to INT_MAX
+#define MAX_TOTAL_PAGES ((uint64_t) INT_MAX + 1)
+
+typedef enum {
+    FORMAT_CSV = 0,
+    FORMAT_BWL
+} format_en;
+
+typedef enum {
+    DIST_EXP = 0,
+    DIST_PARETO
+} dist_en;
+
+typedef struct {
+    uint32_t procs;                 // Number of processes
+    uint32_t bursts;                // Bursts per process
+    double io_ratio;                // Fraction of I/O-bound processes
+    dist_en dist;                   // Distribution of the CPU and block times
+    double pareto_alpha;            // Shape of the Pareto distribution (> 1)
+    double cpu_mean;                // Mean CPU time of a CPU-bound burst (ms)
+    double block_mean;              // Mean block time of an I/O-bound burst (ms)
+    int nice_lo, nice_hi;           // Nice of each process, drawn from [lo, hi]
+    uint32_t pages;                 // Maximum pages touched by a burst
+    uint32_t working_set;           // Pages of each process
+    uint64_t seed;
+    format_en format;
+    const char *out;                // Directory, or trace file
+    int trace;                      // 1 to write one trace file
+} wlgen_options_t;
+
+static const wlgen_options_t DEFAULT_OPTIONS = {
+    .procs = 1000,
+    .bursts = 100,
+    .io_ratio = 0.5,
+    .dist = DIST_EXP,
+    .pareto_alpha = 1.5,
+    .cpu_mean = 200,
+    .block_mean = 2000,
+    .nice_lo = 0,
+    .nice_hi = 0,
+    .pages = 0,
+    .working_set = 64,
+    .seed = 1,
+    .format = FORMAT_CSV
+};
+
+static wlgen_options_t opts;              // DEFAULT_OPTIONS with the command line applied
+
+static _Atomic uint32_t next_proc;      // Next process to generate
+static _Atomic int failed;
+static _Atomic uint64_t total_bytes;
+static void **images;                   // Trace mode: workload of each process
+static size_t *image_sizes;
+
+static uint32_t draw_time(uint64_t *rng, double mean) {
+    double u = rng_uniform01(rng);
+    double v;
+    if (opts.dist == DIST_PARETO) {
+        // Heavy tail: x_m / U^(1/alpha), with x_m chosen so that the mean is mean
+        double xm = mean * (opts.pareto_alpha - 1.0) / opts.pareto_alpha;
+        v = xm / pow(1.0 - u, 1.0 / opts.pareto_alpha);
+    } else {
+        v = -mean * log(1.0 - u);
+    }
+    if (v < 1.0) return 1;
+    return (v >= INT_MAX) ? INT_MAX : (uint32_t) llround(v);
+}
+
+// Generate the bursts of one process
+static int generate(uint32_t proc, burst_queue_t *q) {
+    uint64_t rng = opts.seed ^ (0xD1B54A32D192ED03ULL * (proc + 1));
+    rng_next(&rng);
+    int io_bound = rng_uniform01(&rng) < opts.io_ratio;
+    // Os processos de I/O têm bursts de CPU curtos e bloqueios longos, os de CPU o contrário
+    double cpu_mean = io_bound ? opts.cpu_mean / 10 : opts.cpu_mean;
+    double block_mean = io_bound ? opts.block_mean : opts.block_mean / 10;
+    int nice = opts.nice_lo + (int) (rng_next(&rng) % (uint64_t) (opts.nice_hi - opts.nice_lo + 1));
+    uint32_t base = proc * opts.working_set;    // cada processo tem o seu conjunto de páginas
+
+    for (uint32_t i = 0; i < opts.bursts; i++) {
+        burst_t burst = {
+            .burst_time_ms = draw_time(&rng, cpu_mean),
+            .block_time_ms = (i + 1 < opts.bursts) ? draw_time(&rng, block_mean) : 0,
+            .nice = nice
+        };
+        if (opts.pages > 0) {
+            burst.pages.count = (uint32_t) (rng_next(&rng) % (opts.pages + 1));
+            for (uint32_t p = 0; p < burst.pages.count; p++) {
+                burst.pages.ids[p] = base + (uint32_t) (rng_next(&rng) % opts.working_set);
+            }
+        }
+        if (!enqueue_burst(q, &burst)) return -1;
+    }
+    return 0;
+}
+
+static int write_csv(const char *path, burst_queue_t *q) {
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        perror("fopen");
+        return -1;
+    }
+    fprintf(f, "#cpu(ms),io(ms),nice,[pages]\n");
+    const burst_t *burst;
+    while ((burst = dequeue_burst(q)) != NULL) {
+        fprintf(f, "%u,%u,%d", burst->burst_time_ms, burst->block_time_ms, burst->nice);
+        if (burst->pages.count > 0) {
+            fprintf(f, ",[");
+            for (uint32_t p = 0; p < burst->pages.count; p++) {
+                fprintf(f, p ? ",%u" : "%u", burst->pages.ids[p]);
+            }
+            fprintf(f, "]");
+        }
+        fprintf(f, "\n");
+    }
+    atomic_fetch_add(&total_bytes, (uint64_t) ftell(f));
+    int err = ferror(f);
+    if (fclose(f) != 0 || err) {
+        perror("write");
+        return -1;
+    }
+    return 0;
+}
+
+static int write_proc(uint32_t proc, burst_queue_t *q) {
+    if (opts.trace) {
+        return workload_image(q, &images[proc], &image_sizes[proc]);
+    }
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/wl-%06u.%s", opts.out, proc, opts.format == FORMAT_CSV ? "csv" : "bwl");
+    if (opts.format == FORMAT_CSV) return write_csv(path, q);
+    struct stat st;
+    if (workload_write(q, path) < 0 || stat(path, &st) < 0) return -1;
+    atomic_fetch_add(&total_bytes, (uint64_t) st.st_size);
+    return 0;
+}
+
+static void *worker(void *arg) {
+    (void) arg;
+    burst_queue_t q = {0};
+    uint32_t proc;
+    while (!failed && (proc = atomic_fetch_add(&next_proc, 1)) < opts.procs) {
+        q.count = q.next = 0;   // reaproveita o array entre processos
+        if (generate(proc, &q) < 0 || write_proc(proc, &q) < 0) {
+            fprintf(stderr, "Failed to generate process %u\n", proc);
+            failed = 1;
+        }
+    }
+    free_burst_queue(&q);
+    return NULL;
+}
+
+static int write_trace(void) {
+    size_t header = sizeof(workload_trace_t) + opts.procs * sizeof(uint64_t);
+    workload_trace_t *trace = calloc(1, header);
+    if (!trace) {
+        perror("calloc");
+        return -1;
+    }
+    trace->magic = WORKLOAD_TRACE_MAGIC;
+    trace->version = WORKLOAD_VERSION;
+    trace->count = opts.procs;
+    uint64_t offset = header;
+    for (uint32_t i = 0; i < opts.procs; i++) {
+        offset = (offset + WORKLOAD_TRACE_ALIGN - 1) / WORKLOAD_TRACE_ALIGN * WORKLOAD_TRACE_ALIGN;
+        trace->offsets[i] = offset;
+        offset += image_sizes[i];
+    }
+    FILE *f = fopen(opts.out, "wb");
+    if (!f) {
+        perror("fopen");
+        free(trace);
+        return -1;
+    }
+    static const char zeros[WORKLOAD_TRACE_ALIGN];
+    int ret = (fwrite(trace, 1, header, f) == header) ? 0 : -1;
+    uint64_t pos = header;
+    for (uint32_t i = 0; i < opts.procs && ret == 0; i++) {
+        size_t pad = (size_t) (trace->offsets[i] - pos);
+        if (fwrite(zeros, 1, pad, f) != pad || fwrite(images[i], 1, image_sizes[i], f) != image_sizes[i]) ret = -1;
+        pos = trace->offsets[i] + image_sizes[i];
+    }
+    if (fclose(f) != 0) ret = -1;
+    if (ret < 0) perror("write");
+    total_bytes = pos;
+    free(trace);
+    return ret;
+}
+
+static void usage(const char *prog) {
+    printf("Usage: %s [options] <output-dir | trace.bwlt>\n", prog);
+    printf("  --procs N           processes to generate (default %u)\n", DEFAULT_OPTIONS.procs);
+    printf("  --bursts N          bursts per process (default %u)\n", DEFAULT_OPTIONS.bursts);
+    printf("  --io-ratio F        fraction of I/O-bound processes, 0 to 1 (default %.1f)\n", DEFAULT_OPTIONS.io_ratio);
+    printf("  --dist exp|pareto   distribution of CPU and block times (default exp)\n");
+    printf("  --alpha A           shape of the Pareto distribution, > 1 (default %.1f)\n", DEFAULT_OPTIONS.pareto_alpha);
+    printf("  --cpu-mean MS       mean CPU burst of a CPU-bound process (default %.0f, /10 for I/O-bound)\n", DEFAULT_OPTIONS.cpu_mean);
+    printf("  --block-mean MS     mean block time of an I/O-bound process (default %.0f, /10 for CPU-bound)\n", DEFAULT_OPTIONS.block_mean);
+    printf("  --nice LO:HI        nice of each process, drawn from LO to HI (default %d:%d)\n",
+           DEFAULT_OPTIONS.nice_lo, DEFAULT_OPTIONS.nice_hi);
+    printf("  --pages N           up to N pages per burst (default %u)\n", DEFAULT_OPTIONS.pages);
+    printf("  --working-set N     pages of each process, at most %llu in all (default %u)\n",
+           (unsigned long long) MAX_TOTAL_PAGES, DEFAULT_OPTIONS.working_set);
+    printf("  --seed S            seed of the generator (default %llu)\n", (unsigned long long) DEFAULT_OPTIONS.seed);
+    printf("  --binary            write .bwl files instead of CSV\n");
+    printf("  --trace             write all processes to one workload trace file\n");
+    printf("  --threads N         generator threads (default: number of cores)\n");
+}
+
+int main(int argc, char *argv[]) {
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    opts = DEFAULT_OPTIONS;
+    static const struct option long_options[] = {
+        {"procs", required_argument, NULL, 'n'},
+        {"bursts", required_argument, NULL, 'b'},
+        {"io-ratio", required_argument, NULL, 'i'},
+        {"dist", required_argument, NULL, 'd'},
+        {"alpha", required_argument, NULL, 'a'},
+        {"cpu-mean", required_argument, NULL, 'c'},
+        {"block-mean", required_argument, NULL, 'k'},
+        {"nice", required_argument, NULL, 'N'},
+        {"pages", required_argument, NULL, 'p'},
+        {"working-set", required_argument, NULL, 'w'},
+        {"seed", required_argument, NULL, 's'},
+        {"binary", no_argument, NULL, 'B'},
+        {"trace", no_argument, NULL, 'T'},
+        {"threads", required_argument, NULL, 'j'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "n:b:i:d:a:c:k:N:p:w:s:BTj:", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'n':
+                opts.procs = (uint32_t) strtoul(optarg, NULL, 10);
+                break;
+            case 'b':
+                opts.bursts = (uint32_t) strtoul(optarg, NULL, 10);
+                break;
+            case 'i':
+                opts.io_ratio = atof(optarg);
+                break;
+            case 'd':
+                if (strcmp(optarg, "exp") == 0) {
+                    opts.dist = DIST_EXP;
+                } else if (strcmp(optarg, "pareto") == 0) {
+                    opts.dist = DIST_PARETO;
+                } else {
+                    usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'a':
+                opts.pareto_alpha = atof(optarg);
+                break;
+            case 'c':
+                opts.cpu_mean = atof(optarg);
+                break;
+            case 'k':
+                opts.block_mean = atof(optarg);
+                break;
+            case 'N':
+                if (sscanf(optarg, "%d:%d", &opts.nice_lo, &opts.nice_hi) != 2) {
+                    usage(argv[0]);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'p':
+                opts.pages = (uint32_t) strtoul(optarg, NULL, 10);
+                break;
+            case 'w':
+                opts.working_set = (uint32_t) strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                opts.seed = strtoull(optarg, NULL, 10);
+                break;
+            case 'B':
+                opts.format = FORMAT_BWL;
+                break;
+            case 'T':
+                opts.trace = 1;
+                break;
+            case 'j':
+                threads = atol(optarg);
+                break;
+            default:
+                usage(argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+    if (argc - optind != 1 || opts.procs == 0 || opts.bursts == 0 || opts.io_ratio < 0 || opts.io_ratio > 1 ||
+        opts.pareto_alpha <= 1 || opts.cpu_mean <= 0 || opts.block_mean <= 0 || opts.nice_lo > opts.nice_hi ||
+        opts.pages > MAX_PAGES || opts.working_set == 0 ||
+        (uint64_t) opts.procs * opts.working_set > MAX_TOTAL_PAGES || threads <= 0) {
+        usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    opts.out = argv[optind];
+    if (threads > (long) opts.procs) threads = (long) opts.procs;
+
+    if (opts.trace) {
+        images = calloc(opts.procs, sizeof(void *));
+        image_sizes = calloc(opts.procs, sizeof(size_t));
+        if (!images || !image_sizes) {
+            perror("calloc");
+            return EXIT_FAILURE;
+        }
+    } else if (mkdir(opts.out, 0755) < 0 && errno != EEXIST) {
+        perror("mkdir");
+        return EXIT_FAILURE;
+    }
+
+    double t0 = now_s();
+    pthread_t *tids = malloc((size_t) threads * sizeof(pthread_t));
+    if (!tids) {
+        perror("malloc");
+        return EXIT_FAILURE;
+    }
+    long started = 0;
+    for (; started < threads; started++) {
+        int err = pthread_create(&tids[started], NULL, worker, NULL);
+        if (err != 0) {
+            fprintf(stderr, "pthread_create: %s\n", strerror(err));
+            break;
+        }
+    }
+    if (started == 0) worker(NULL);
+    for (long t = 0; t < started; t++) pthread_join(tids[t], NULL);
+    free(tids);
+    if (!failed && opts.trace && write_trace() < 0) failed = 1;
+    double seconds = now_s() - t0;
+
+    if (opts.trace) {
+        for (uint32_t i = 0; i < opts.procs; i++) free(images[i]);
+        free(images);
+        free(image_sizes);
+    }
+    if (failed) return EXIT_FAILURE;
+    printf("Generated %u processes x %u bursts (%llu bytes) into %s in %.3f s with %ld threads\n",
+           opts.procs, opts.bursts, (unsigned long long) total_bytes, opts.out, seconds, started ? started : 1);
+    return EXIT_SUCCESS;
+}
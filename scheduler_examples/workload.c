@@ -0,0 +1,198 @@
+#include "workload.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Worst case of a zigzag varint of a 33-bit difference
+#define VARINT_MAX_BYTES 5
+
+static const workload_burst_t *records(const workload_header_t *hdr) {
+    return (const workload_burst_t *) (hdr + 1);
+}
+
+static const uint8_t *page_bytes(const workload_header_t *hdr) {
+    return (const uint8_t *) (records(hdr) + hdr->count);
+}
+
+const workload_header_t *workload_check(const void *data, size_t size) {
+    if (size < sizeof(workload_header_t)) return NULL;
+    const workload_header_t *hdr = data;
+    if (hdr->magic != WORKLOAD_MAGIC) return NULL;
+    if (hdr->version != WORKLOAD_VERSION || hdr->burst_size != sizeof(workload_burst_t)) {
+        fprintf(stderr, "Unsupported binary workload (version %u)\n", hdr->version);
+        return NULL;
+    }
+    if ((size - sizeof(workload_header_t)) / sizeof(workload_burst_t) < hdr->count ||
+        size - sizeof(workload_header_t) - hdr->count * sizeof(workload_burst_t) != hdr->page_bytes) {
+        fprintf(stderr, "Truncated binary workload\n");
+        return NULL;
+    }
+    return hdr;
+}
+
+// The difference between two uint32 pages needs 33 bits, so it is encoded as 64 bits
+static uint64_t zigzag(int64_t v) {
+    return ((uint64_t) v << 1) ^ (uint64_t) (v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v) {
+    return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);
+}
+
+int workload_decode(const workload_header_t *hdr, size_t index, burst_t *burst) {
+    const workload_burst_t *rec = &records(hdr)[index];
+    burst->burst_time_ms = rec->burst_time_ms;
+    burst->block_time_ms = rec->block_time_ms;
+    burst->nice = rec->nice;
+    burst->pages.count = 0;
+    if (rec->page_count == 0) return 0;
+    if (rec->page_count > MAX_PAGES || rec->page_offset >= hdr->page_bytes) return -1;
+
+    const uint8_t *p = page_bytes(hdr) + rec->page_offset;
+    const uint8_t *end = page_bytes(hdr) + hdr->page_bytes;
+    int64_t page = 0;
+    for (uint32_t i = 0; i < rec->page_count; i++) {
+        uint64_t v = 0;
+        int shift = 0;
+        do {
+            if (p == end || shift >= 7 * VARINT_MAX_BYTES) return -1;
+            v |= (uint64_t) (*p & 0x7f) << shift;
+            shift += 7;
+        } while (*p++ & 0x80);
+        page += unzigzag(v);
+        if (page < 0 || page > UINT32_MAX) return -1;
+        burst->pages.ids[i] = (uint32_t) page;
+    }
+    burst->pages.count = rec->page_count;
+    return 0;
+}
+
+// Append the encoded pages of a burst to buf, growing it as needed
+static int encode_pages(const burst_t *burst, uint8_t **buf, size_t *len, size_t *cap) {
+    uint32_t count = burst->pages.count < MAX_PAGES ? burst->pages.count : MAX_PAGES;
+    if (*len + (size_t) count * VARINT_MAX_BYTES > *cap) {
+        size_t new_cap = *cap ? *cap : 4096;
+        while (*len + (size_t) count * VARINT_MAX_BYTES > new_cap) new_cap *= 2;
+        uint8_t *p = realloc(*buf, new_cap);
+        if (!p) return -1;
+        *buf = p;
+        *cap = new_cap;
+    }
+    int64_t prev = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uint64_t v = zigzag((int64_t) burst->pages.ids[i] - prev);
+        prev = burst->pages.ids[i];
+        while (v >= 0x80) {
+            (*buf)[(*len)++] = (uint8_t) (v | 0x80);
+            v >>= 7;
+        }
+        (*buf)[(*len)++] = (uint8_t) v;
+    }
+    return 0;
+}
+
+int workload_image(burst_queue_t *q, void **image, size_t *size) {
+    size_t count = burst_queue_remaining(q);
+    if (count > UINT32_MAX) {
+        fprintf(stderr, "Too many bursts for a binary workload\n");
+        return -1;
+    }
+    workload_burst_t *recs = malloc((count ? count : 1) * sizeof(workload_burst_t));
+    if (!recs) {
+        perror("malloc");
+        return -1;
+    }
+    uint8_t *pages = NULL;
+    size_t pages_len = 0, pages_cap = 0;
+    int ret = 0;
+    for (size_t i = 0; i < count && ret == 0; i++) {
+        const burst_t *burst = dequeue_burst(q);
+        if (!burst) {
+            ret = -1;
+            break;
+        }
+        recs[i] = (workload_burst_t) {
+            .burst_time_ms = burst->burst_time_ms,
+            .block_time_ms = burst->block_time_ms,
+            .nice = burst->nice,
+            .page_count = burst->pages.count < MAX_PAGES ? burst->pages.count : MAX_PAGES,
+            .page_offset = (uint32_t) pages_len
+        };
+        if (encode_pages(burst, &pages, &pages_len, &pages_cap) < 0 || pages_len > UINT32_MAX) {
+            fprintf(stderr, "Page list too large for a binary workload\n");
+            ret = -1;
+        }
+    }
+    workload_header_t hdr = {
+        .magic = WORKLOAD_MAGIC,
+        .version = WORKLOAD_VERSION,
+        .burst_size = sizeof(workload_burst_t),
+        .count = (uint32_t) count,
+        .page_bytes = (uint32_t) pages_len
+    };
+    size_t len = sizeof(hdr) + count * sizeof(workload_burst_t) + pages_len;
+    uint8_t *p = (ret == 0) ? malloc(len) : NULL;
+    if (ret == 0 && !p) {
+        perror("malloc");
+        ret = -1;
+    }
+    if (ret == 0) {
+        memcpy(p, &hdr, sizeof(hdr));
+        memcpy(p + sizeof(hdr), recs, count * sizeof(workload_burst_t));
+        if (pages_len) memcpy(p + sizeof(hdr) + count * sizeof(workload_burst_t), pages, pages_len);
+        *image = p;
+        *size = len;
+    }
+    free(recs);
+    free(pages);
+    return ret;
+}
+
+int workload_write(burst_queue_t *q, const char *filename) {
+    void *image;
+    size_t size;
+    if (workload_image(q, &image, &size) < 0) return -1;
+    int ret = 0;
+    FILE *f = fopen(filename, "wb");
+    if (!f) {
+        perror("fopen");
+        ret = -1;
+    } else {
+        if (fwrite(image, 1, size, f) != size) {
+            perror("fwrite");
+            ret = -1;
+        }
+        if (fclose(f) != 0 && ret == 0) {
+            perror("fclose");
+            ret = -1;
+        }
+    }
+    free(image);
+    return ret;
+}
+
+const workload_trace_t *workload_trace_check(const void *data, size_t size) {
+    if (size < sizeof(workload_trace_t)) return NULL;
+    const workload_trace_t *trace = data;
+    if (trace->magic != WORKLOAD_TRACE_MAGIC) return NULL;
+    if (trace->version != WORKLOAD_VERSION ||
+        (size - sizeof(workload_trace_t)) / sizeof(uint64_t) < trace->count) {
+        fprintf(stderr, "Unsupported or truncated workload trace\n");
+        return NULL;
+    }
+    return trace;
+}
+
+const workload_header_t *workload_trace_get(const workload_trace_t *trace, size_t size, size_t index) {
+    uint64_t start = trace->offsets[index];
+    uint64_t end = (index + 1 < trace->count) ? trace->offsets[index + 1] : size;
+    if (start > end || end > size || start % WORKLOAD_TRACE_ALIGN != 0 || end - start < sizeof(workload_header_t)) {
+        return NULL;
+    }
+    // The workload may be followed by padding up to the next one
+    const workload_header_t *hdr = (const void *) ((const uint8_t *) trace + start);
+    uint64_t len = sizeof(workload_header_t) + (uint64_t) hdr->count * sizeof(workload_burst_t) + hdr->page_bytes;
+    if (len > end - start) return NULL;
+    return workload_check(hdr, (size_t) len);
+}
@@ -0,0 +1,120 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "burst_queue.h"
+
+/*
+ * Precompiled binary workload (.bwl), as written by burstc:
+ *
+ *   workload_header_t | workload_burst_t[count] | page bytes
+ *
+ * The burst records have a fixed size, so burst i is found without reading the
+ * ones before it. The pages of a burst are stored in the page bytes from its
+ * page_offset on, each one as the zigzag varint of its difference to the
+ * previous page of the burst (the first one to 0). All fields are in host byte
+ * order, like the messages of the simulator.
+ */
+
+#define WORKLOAD_MAGIC   0x314C5742u        // "BWL1"
+#define WORKLOAD_VERSION 1
+
+typedef struct workload_header_st {
+    uint32_t magic;                 // WORKLOAD_MAGIC
+    uint16_t version;               // WORKLOAD_VERSION
+    uint16_t burst_size;            // sizeof(workload_burst_t)
+    uint32_t count;                 // Number of bursts
+    uint32_t page_bytes;            // Size of the page bytes
+} workload_header_t;
+
+typedef struct {
+    uint32_t burst_time_ms;
+    uint32_t block_time_ms;
+    int32_t nice;
+    uint32_t page_count;            // Number of pages (up to MAX_PAGES)
+    uint32_t page_offset;           // Offset of the first page in the page bytes
+} workload_burst_t;
+
+/**
+ * @brief Check whether a mapped file is a binary workload
+ *
+ * Only the header is read: the bursts are checked when decoded.
+ *
+ * @param data The start of the file
+ * @param size The size of the file
+ * @return The header if data holds a valid binary workload, NULL otherwise
+ */
+const workload_header_t *workload_check(const void *data, size_t size);
+
+/**
+ * @brief Decode one burst of a binary workload
+ *
+ * @param hdr The header returned by workload_check (the file follows it)
+ * @param index The burst, from 0 to hdr->count - 1
+ * @param burst Receives the burst
+ * @return 0 on success, -1 if the burst is corrupted
+ */
+int workload_decode(const workload_header_t *hdr, size_t index, burst_t *burst);
+
+/**
+ * @brief Encode the bursts of a queue (from its cursor on) as a binary workload in memory
+ *
+ * @param q The bursts
+ * @param image Receives the contents of the file, to free
+ * @param size Receives its size
+ * @return 0 on success, -1 on failure
+ */
+int workload_image(burst_queue_t *q, void **image, size_t *size);
+
+/**
+ * @brief Write the bursts of a queue (from its cursor on) as a binary workload
+ *
+ * @param q The bursts
+ * @param filename The file to create
+ * @return 0 on success, -1 on failure
+ */
+int workload_write(burst_queue_t *q, const char *filename);
+
+/*
+ * Workload trace (.bwlt), as written by wlgen: the workloads of many processes in
+ * one file.
+ *
+ *   workload_trace_t | offsets[count] | padding | workload | padding | workload ...
+ *
+ * Each workload is a complete binary workload as above, starting at its offset
+ * from the start of the file (a multiple of WORKLOAD_TRACE_ALIGN).
+ */
+
+#define WORKLOAD_TRACE_MAGIC 0x544C5742u   // "BWLT"
+#define WORKLOAD_TRACE_ALIGN 8
+
+typedef struct {
+    uint32_t magic;                 // WORKLOAD_TRACE_MAGIC
+    uint16_t version;               // WORKLOAD_VERSION
+    uint16_t reserved;
+    uint64_t count;                 // Number of workloads
+    uint64_t offsets[];             // Offset of each workload
+} workload_trace_t;
+
+/**
+ * @brief Check whether a mapped file is a workload trace
+ *
+ * @param data The start of the file
+ * @param size The size of the file
+ * @return The trace, or NULL if data is not a valid trace
+ */
+const workload_trace_t *workload_trace_check(const void *data, size_t size);
+
+/**
+ * @brief Find one workload of a trace
+ *
+ * @param trace The trace returned by workload_trace_check
+ * @param size The size of the file
+ * @param index The workload, from 0 to trace->count - 1
+ * @return The workload (decode it with workload_decode), or NULL if it is corrupted
+ */
+const workload_header_t *workload_trace_get(const workload_trace_t *trace, size_t size, size_t index);
+
+#endif //WORKLOAD_H